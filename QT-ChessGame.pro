@@ -0,0 +1,24 @@
+QT += core gui widgets
+
+TARGET = QT-ChessGame
+TEMPLATE = app
+
+# constexpr-функции bitboard.h требуют C++14, выровненный new для NnueNetwork — C++17
+CONFIG += c++17
+
+SOURCES += \
+    main.cpp \
+    mainwindow.cpp \
+    chessboard.cpp \
+    chessai.cpp \
+    bitboard.cpp \
+    nnue.cpp \
+    transpositiontable.cpp
+
+HEADERS += \
+    mainwindow.h \
+    chessboard.h \
+    chessai.h \
+    bitboard.h \
+    nnue.h \
+    transpositiontable.h
@@ -0,0 +1,130 @@
+#include "bitboard.h"
+
+#if !defined(__BMI2__) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define BITBOARD_RUNTIME_BMI2
+#endif
+
+namespace Bitboards {
+
+// Магические числа без разрушительных коллизий для сдвига 64 - popcount(mask).
+// Найдены и проверяются программой tools/magicgen.cpp
+const Bitboard ROOK_MAGICS[64] = {
+    0x1880008020104000ULL, 0x8240002001100048ULL, 0x1080200080081000ULL, 0x5080100080080104ULL,
+    0x5100100800030004ULL, 0x0200011084020008ULL, 0x2080010002000080ULL, 0x05000A008240A500ULL,
+    0x0040800040002081ULL, 0x0005004001008028ULL, 0x2080802000100080ULL, 0x5002000A024110A0ULL,
+    0x0410800400080081ULL, 0x0002000200049088ULL, 0xC004000250244108ULL, 0x10C2000200804411ULL,
+    0x4040008008204880ULL, 0x0040010040810020ULL, 0xE820010011004020ULL, 0x000892000A0040A0ULL,
+    0x5224010100080010ULL, 0x0004808004010200ULL, 0x0040040021181210ULL, 0x0850020013086084ULL,
+    0x9124800880244000ULL, 0x0400400240201001ULL, 0x8090002020080401ULL, 0x1080080080100081ULL,
+    0x1008041100080101ULL, 0x104100090004001EULL, 0x0881002100020024ULL, 0x0410801880004100ULL,
+    0x0440204005800880ULL, 0x4900401004402000ULL, 0x0890040801200120ULL, 0x0001800802801002ULL,
+    0x0004000800800480ULL, 0x04AD020080800400ULL, 0x0000108204000108ULL, 0x0002004102000084ULL,
+    0x0008882040008000ULL, 0x0220004000828028ULL, 0x0210100020008080ULL, 0x0806001008220040ULL,
+    0x0000080004008080ULL, 0x200C000200048080ULL, 0x8424010002008080ULL, 0x0100090048A20004ULL,
+    0x088008814000A580ULL, 0x100A002041088200ULL, 0x00024B9100A00100ULL, 0x8022001040886600ULL,
+    0x4800040080080080ULL, 0x0520020080040080ULL, 0x0282011002484400ULL, 0x86852415004A8200ULL,
+    0x0201482103108001ULL, 0x83010850A480C001ULL, 0x28051020420A0082ULL, 0x1180042008100101ULL,
+    0x0202000490082082ULL, 0x0005000400080201ULL, 0x4400102102008804ULL, 0x0202002041040092ULL
+};
+
+const Bitboard BISHOP_MAGICS[64] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL, 0x5204042080000088ULL,
+    0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200A02020ULL,
+    0x1500241990010E00ULL, 0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL, 0x8000088400880520ULL,
+    0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+    0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+    0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422C012400ULL, 0x0002128698404812ULL,
+    0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802A02020000B098ULL,
+    0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488A00ULL,
+    0x2000081104004040ULL, 0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+    0x4A1500401041004AULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+    0x0040808800B62048ULL, 0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL
+};
+
+SliderEntry rookEntries[64];
+SliderEntry bishopEntries[64];
+bool usePext = false;
+
+namespace {
+
+// Размеры таблиц: сумма 2^popcount(mask) по всем клеткам
+Bitboard rookTable[0x19000];
+Bitboard bishopTable[0x1480];
+
+#if defined(BITBOARD_RUNTIME_BMI2)
+__attribute__((target("bmi2"))) quint64 pextBmi2(Bitboard occupied, Bitboard mask)
+{
+    return _pext_u64(occupied, mask);
+}
+
+bool cpuHasBmi2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+}
+#endif
+
+void initSliders(SliderEntry *entries, Bitboard *table, bool diagonal, const Bitboard *magics, bool pextIndexing)
+{
+    Bitboard *next = table;
+    for (int sq = 0; sq < 64; ++sq) {
+        SliderEntry &entry = entries[sq];
+        entry.mask = diagonal ? STEP_ATTACKS.bishopMask[sq] : STEP_ATTACKS.rookMask[sq];
+        entry.shift = unsigned(64 - popCount(entry.mask));
+        entry.attacks = next;
+        entry.magic = magics[sq];
+
+        // Перебор всех подмножеств маски (Carry-Rippler)
+        int size = 0;
+        Bitboard subset = 0;
+        do {
+            unsigned index = pextIndexing ? unsigned(pext(subset, entry.mask))
+                                          : unsigned((subset * entry.magic) >> entry.shift);
+            next[index] = slidingAttacks(sq, subset, diagonal);
+            ++size;
+            subset = (subset - entry.mask) & entry.mask;
+        } while (subset);
+
+        next += size;
+    }
+}
+
+struct SliderTablesInit {
+    SliderTablesInit()
+    {
+#if defined(__BMI2__)
+        usePext = true;
+#elif defined(BITBOARD_RUNTIME_BMI2)
+        usePext = cpuHasBmi2();
+#endif
+        initSliders(rookEntries, rookTable, false, ROOK_MAGICS, usePext);
+        initSliders(bishopEntries, bishopTable, true, BISHOP_MAGICS, usePext);
+    }
+};
+
+// Таблицы заполняются при статической инициализации, до первого обращения
+const SliderTablesInit sliderTablesInit;
+
+}
+
+#if !defined(__BMI2__)
+// Без BMI2 при сборке PEXT вызывается только если его нашли в процессоре при запуске
+quint64 pext(Bitboard occupied, Bitboard mask)
+{
+#if defined(BITBOARD_RUNTIME_BMI2)
+    return pextBmi2(occupied, mask);
+#else
+    Q_UNUSED(occupied);
+    Q_UNUSED(mask);
+    return 0;
+#endif
+}
+#endif
+
+}
@@ -0,0 +1,205 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Битборды: бит с номером row * 8 + col соответствует клетке board[row][col],
+// то есть нулевой бит — a8, 63-й — h1. Белые пешки идут в сторону уменьшения номера.
+typedef quint64 Bitboard;
+
+namespace Bitboards {
+
+constexpr Bitboard squareBit(int square) { return Bitboard(1) << square; }
+
+inline int lsb(Bitboard b) { return int(qCountTrailingZeroBits(b)); }
+inline int popLsb(Bitboard &b) { int square = lsb(b); b &= b - 1; return square; }
+inline int popCount(Bitboard b) { return int(qPopulationCount(b)); }
+inline bool moreThanOne(Bitboard b) { return (b & (b - 1)) != 0; }
+
+// Шаг на (dr, dc) с клетки square; 0, если уходим за край доски
+constexpr Bitboard stepBit(int square, int dr, int dc)
+{
+    int row = square / 8 + dr;
+    int col = square % 8 + dc;
+    return (row >= 0 && row < 8 && col >= 0 && col < 8) ? squareBit(row * 8 + col) : 0;
+}
+
+// Лучи дальнобойной фигуры с учётом блокирующих фигур occupied.
+// Используется для генерации таблиц и в constexpr-контексте
+// (циклы в constexpr-функциях требуют C++14, см. QT-ChessGame.pro)
+constexpr Bitboard slidingAttacks(int square, Bitboard occupied, bool diagonal)
+{
+    const int rookDirs[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+    const int bishopDirs[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; ++d) {
+        int dr = diagonal ? bishopDirs[d][0] : rookDirs[d][0];
+        int dc = diagonal ? bishopDirs[d][1] : rookDirs[d][1];
+        int row = square / 8 + dr;
+        int col = square % 8 + dc;
+        while (row >= 0 && row < 8 && col >= 0 && col < 8) {
+            attacks |= squareBit(row * 8 + col);
+            if (occupied & squareBit(row * 8 + col)) {
+                break;
+            }
+            row += dr;
+            col += dc;
+        }
+    }
+    return attacks;
+}
+
+struct StepAttackTables {
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64]; // [цвет][клетка]: клетки, которые бьёт пешка этого цвета
+    Bitboard rookMask[64];   // значимые для магии клетки (без края луча)
+    Bitboard bishopMask[64];
+};
+
+constexpr StepAttackTables makeStepAttackTables()
+{
+    StepAttackTables t = {};
+    for (int sq = 0; sq < 64; ++sq) {
+        t.knight[sq] = stepBit(sq, 2, 1) | stepBit(sq, 2, -1) | stepBit(sq, -2, 1) | stepBit(sq, -2, -1) |
+                       stepBit(sq, 1, 2) | stepBit(sq, 1, -2) | stepBit(sq, -1, 2) | stepBit(sq, -1, -2);
+        t.king[sq] = stepBit(sq, 1, 1) | stepBit(sq, 1, 0) | stepBit(sq, 1, -1) | stepBit(sq, 0, 1) |
+                     stepBit(sq, 0, -1) | stepBit(sq, -1, 1) | stepBit(sq, -1, 0) | stepBit(sq, -1, -1);
+        t.pawn[0][sq] = stepBit(sq, -1, -1) | stepBit(sq, -1, 1); // белые
+        t.pawn[1][sq] = stepBit(sq, 1, -1) | stepBit(sq, 1, 1);   // черные
+
+        // Крайняя клетка луча не влияет на атаки, поэтому в маску не входит.
+        // У слона это вся кромка доски, у ладьи — только концы лучей
+        Bitboard edges = 0;
+        for (int i = 0; i < 8; ++i) {
+            edges |= squareBit(i) | squareBit(56 + i) | squareBit(i * 8) | squareBit(i * 8 + 7);
+        }
+        t.bishopMask[sq] = slidingAttacks(sq, 0, true) & ~edges;
+
+        int row = sq / 8, col = sq % 8;
+        Bitboard mask = 0;
+        for (int r = row + 1; r < 7; ++r) mask |= squareBit(r * 8 + col);
+        for (int r = row - 1; r > 0; --r) mask |= squareBit(r * 8 + col);
+        for (int c = col + 1; c < 7; ++c) mask |= squareBit(row * 8 + c);
+        for (int c = col - 1; c > 0; --c) mask |= squareBit(row * 8 + c);
+        t.rookMask[sq] = mask;
+    }
+    return t;
+}
+
+struct LineTables {
+    Bitboard between[64][64]; // клетки строго между from и to, если они на одной линии
+    Bitboard line[64][64];    // вся линия через from и to (включая их), иначе 0
+};
+
+// Обходим только пары клеток на общей линии, идя по лучам: без вызовов
+// slidingAttacks на каждую пару вычисление укладывается в лимиты constexpr
+// компиляторов (у clang по умолчанию 2^20 шагов)
+constexpr LineTables makeLineTables()
+{
+    // Противоположные направления стоят рядом: d и d ^ 1
+    const int dirs[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1} };
+
+    Bitboard rays[64][8] = {};
+    for (int sq = 0; sq < 64; ++sq) {
+        for (int d = 0; d < 8; ++d) {
+            int row = sq / 8 + dirs[d][0];
+            int col = sq % 8 + dirs[d][1];
+            while (row >= 0 && row < 8 && col >= 0 && col < 8) {
+                rays[sq][d] |= squareBit(row * 8 + col);
+                row += dirs[d][0];
+                col += dirs[d][1];
+            }
+        }
+    }
+
+    LineTables t = {};
+    for (int from = 0; from < 64; ++from) {
+        for (int d = 0; d < 8; ++d) {
+            Bitboard line = rays[from][d] | rays[from][d ^ 1] | squareBit(from);
+            Bitboard between = 0;
+            int row = from / 8 + dirs[d][0];
+            int col = from % 8 + dirs[d][1];
+            while (row >= 0 && row < 8 && col >= 0 && col < 8) {
+                int to = row * 8 + col;
+                t.between[from][to] = between;
+                t.line[from][to] = line;
+                between |= squareBit(to);
+                row += dirs[d][0];
+                col += dirs[d][1];
+            }
+        }
+    }
+    return t;
+}
+
+// inline (C++17): одна копия таблиц на программу, а не на каждый файл с этим заголовком
+inline constexpr StepAttackTables STEP_ATTACKS = makeStepAttackTables();
+inline constexpr LineTables LINES = makeLineTables();
+
+inline Bitboard knightAttacks(int square) { return STEP_ATTACKS.knight[square]; }
+inline Bitboard kingAttacks(int square) { return STEP_ATTACKS.king[square]; }
+inline Bitboard pawnAttacks(int color, int square) { return STEP_ATTACKS.pawn[color][square]; }
+inline Bitboard between(int from, int to) { return LINES.between[from][to]; }
+inline Bitboard line(int from, int to) { return LINES.line[from][to]; }
+
+// Таблицы дальнобойных фигур заполняются при запуске: индекс считается
+// через PEXT, если процессор поддерживает BMI2, иначе через заранее найденные
+// магические числа (ROOK_MAGICS, BISHOP_MAGICS)
+struct SliderEntry {
+    Bitboard mask;
+    Bitboard magic;
+    const Bitboard *attacks;
+    unsigned shift;
+};
+
+extern const Bitboard ROOK_MAGICS[64];
+extern const Bitboard BISHOP_MAGICS[64];
+extern SliderEntry rookEntries[64];
+extern SliderEntry bishopEntries[64];
+extern bool usePext;
+
+#if defined(__BMI2__)
+inline quint64 pext(Bitboard occupied, Bitboard mask) { return _pext_u64(occupied, mask); }
+#else
+quint64 pext(Bitboard occupied, Bitboard mask);
+#endif
+
+inline unsigned sliderIndex(const SliderEntry &entry, Bitboard occupied)
+{
+#if defined(__BMI2__)
+    return unsigned(pext(occupied, entry.mask));
+#else
+    if (usePext) {
+        return unsigned(pext(occupied, entry.mask));
+    }
+    return unsigned(((occupied & entry.mask) * entry.magic) >> entry.shift);
+#endif
+}
+
+inline Bitboard rookAttacks(int square, Bitboard occupied)
+{
+    const SliderEntry &entry = rookEntries[square];
+    return entry.attacks[sliderIndex(entry, occupied)];
+}
+
+inline Bitboard bishopAttacks(int square, Bitboard occupied)
+{
+    const SliderEntry &entry = bishopEntries[square];
+    return entry.attacks[sliderIndex(entry, occupied)];
+}
+
+inline Bitboard queenAttacks(int square, Bitboard occupied)
+{
+    return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+}
+
+}
+
+#endif // BITBOARD_H
@@ -1,92 +1,586 @@
 #include "chessai.h"
 #include <QDebug>
 #include <algorithm>
-#include <limits>
+
+namespace {
+
+const int INF_SCORE = 1000000;
+const int MATE_SCORE = 100000;
+const int MATE_BOUND = MATE_SCORE - MAX_PLY;
+const int KILLER_SCORE = 1000;
+const int TT_MOVE_SCORE = 100000;
+// Выгодные взятия идут первыми, проигрывающие размен — после тихих ходов
+const int GOOD_CAPTURE_SCORE = 10000;
+const int BAD_CAPTURE_SCORE = -30000;
+const int DRAW_SCORE = 0;
+
+// Поля отсечений по глубине (в сантипешках)
+const int FUTILITY_MARGIN[] = { 0, 200, 450 };
+const int RAZOR_MARGIN[] = { 0, 300, 550 };
+const int ASPIRATION_WINDOW = 50;
+// Допустимая потеря в размене на глубину у листьев
+const int SEE_PRUNE_MARGIN = 100;
+
+// Веса фигур для упорядочивания взятий (MVV-LVA)
+const int ORDER_VALUES[] = { 0, 1, 3, 3, 5, 9, 20 };
+
+// В таблице мат считается от сохранённой позиции, а в поиске — от корня
+int scoreToTable(int score, int ply)
+{
+    if (score >= MATE_BOUND) {
+        return score + ply;
+    }
+    if (score <= -MATE_BOUND) {
+        return score - ply;
+    }
+    return score;
+}
+
+int scoreFromTable(int score, int ply)
+{
+    if (score >= MATE_BOUND) {
+        return score - ply;
+    }
+    if (score <= -MATE_BOUND) {
+        return score + ply;
+    }
+    return score;
+}
+
+}
+
 // TODO King can not be beaten. Need to fix
 ChessAI::ChessAI(ChessBoard *board, QObject *parent)
-    : QObject(parent), chessBoard(board)
+    : QObject(parent), chessBoard(board), stack(new SearchStack), table(new TranspositionTable(DEFAULT_TT_SIZE_MB)),
+      network(nullptr), nodes(0),
+      abortAllowed(false), aborted(false)
+{
+}
+
+ChessAI::~ChessAI()
+{
+}
+
+void ChessAI::setTranspositionTableSize(int megabytes)
+{
+    table.reset(new TranspositionTable(qMax(1, megabytes)));
+}
+
+SearchResult ChessAI::findBestMove(int depth)
+{
+    SearchLimits depthLimit;
+    depthLimit.depth = depth;
+    return findBestMove(chessBoard->getBoardData(), chessBoard->getPositionHistory(), depthLimit);
+}
+
+SearchResult ChessAI::findBestMove(const ChessBoardData &boardData, const QVector<quint64> &history,
+                                   const SearchLimits &searchLimits)
+{
+    QVector<SearchResult> lines = findBestMoves(boardData, history, searchLimits, 1);
+    return lines.isEmpty() ? SearchResult() : lines.first();
+}
+
+QVector<SearchResult> ChessAI::findBestMoves(int depth, int lineCount)
 {
+    SearchLimits depthLimit;
+    depthLimit.depth = depth;
+    return findBestMoves(chessBoard->getBoardData(), chessBoard->getPositionHistory(), depthLimit, lineCount);
 }
 
-ChessMove ChessAI::findBestMove(int depth)
+QVector<SearchResult> ChessAI::findBestMoves(const ChessBoardData &boardData, const QVector<quint64> &history,
+                                             const SearchLimits &searchLimits, int lineCount)
 {
-    ChessBoardData currentData = chessBoard->getBoardData();
-    QVector<ChessMove> allMoves = getAllPossibleMoves(&currentData, BLACK);
+    position = boardData;
+    limits = searchLimits;
+    nodes = 0;
+    aborted = false;
+    timer.start();
+    table->newSearch();
 
-    if (allMoves.isEmpty()) {
-        return ChessMove();
+    QVector<SearchResult> lines;
+    SearchPly &root = stack->plies[0];
+    root.moves.clear();
+    position.generateLegalMoves(position.currentPlayer, root.moves);
+    for (int ply = 0; ply < MAX_PLY; ++ply) {
+        stack->plies[ply].killers[0] = ChessMove();
+        stack->plies[ply].killers[1] = ChessMove();
+        stack->plies[ply].pvLength = 0;
     }
 
-    int bestScore = std::numeric_limits<int>::min();
-    ChessMove bestMove;
+    if (root.moves.isEmpty()) {
+        return lines;
+    }
+    lineCount = qBound(1, lineCount, root.moves.size());
+
+    // История партии до последнего необратимого хода для поиска повторений
+    int historyLength = std::min(std::min(history.size(), position.halfmoveClock), MAX_HISTORY);
+    for (int i = 0; i < historyLength; ++i) {
+        stack->keys[i] = history[history.size() - historyLength + i];
+    }
+    stack->rootIndex = historyLength;
+    stack->keys[stack->rootIndex] = position.key;
 
-    for (ChessMove &move : allMoves) {
-        ChessBoardData newData = currentData;
-        ChessBoard tempBoard;
-        tempBoard.setBoardData(newData);
-        tempBoard.makeMoveForAI(move.fromRow, move.fromCol, move.toRow, move.toCol);
+    // Дальше аккумулятор сети обновляется по ходам, с нуля — только в корне
+    if (network) {
+        network->refresh(position, root.accumulator);
+    }
 
-        int score = minimax(tempBoard.getBoardData(), depth - 1,
-                          std::numeric_limits<int>::min(),
-                          std::numeric_limits<int>::max(), false);
+    // Итеративное углубление. На каждой глубине линии ищутся по очереди:
+    // найденный ход переносится в начало списка, и следующая линия его уже не видит.
+    // Окно каждой линии строится вокруг её оценки на прошлой итерации
+    int completedDepth = 0;
+    int maxDepth = std::min(limits.depth, MAX_PLY - 1);
+    for (int currentDepth = 1; currentDepth <= maxDepth; ++currentDepth) {
+        abortAllowed = currentDepth > 1;
 
-        move.score = score;
+        for (int line = 0; line < lineCount; ++line) {
+            int score = 0;
+            if (completedDepth > 0) {
+                const RootLine &previous = stack->completedLines[line];
+                score = previous.score;
+                // Ход, стоявший на этом месте в прошлой итерации, смотрим первым
+                for (int i = line + 1; i < root.moves.size(); ++i) {
+                    if (root.moves[i] == previous.pv[0]) {
+                        std::swap(root.moves[line], root.moves[i]);
+                        break;
+                    }
+                }
+            }
+
+            int delta = ASPIRATION_WINDOW;
+            int alpha = -INF_SCORE;
+            int beta = INF_SCORE;
+            if (options.aspirationWindows && currentDepth >= 3) {
+                alpha = std::max(score - delta, -INF_SCORE);
+                beta = std::min(score + delta, INF_SCORE);
+            }
+
+            while (true) {
+                score = searchRoot(currentDepth, alpha, beta, line);
+                if (aborted) {
+                    break;
+                }
+                if (score <= alpha && alpha > -INF_SCORE) {
+                    alpha = std::max(score - delta, -INF_SCORE);
+                } else if (score >= beta && beta < INF_SCORE) {
+                    beta = std::min(score + delta, INF_SCORE);
+                } else {
+                    break;
+                }
+                delta *= 2;
+            }
+            if (aborted) {
+                break;
+            }
+
+            RootLine &current = stack->currentLines[line];
+            current.score = score;
+            current.pvLength = root.pvLength;
+            std::copy(root.pv, root.pv + root.pvLength, current.pv);
+            for (int i = line + 1; i < root.moves.size(); ++i) {
+                if (root.moves[i] == root.pv[0]) {
+                    std::swap(root.moves[line], root.moves[i]);
+                    break;
+                }
+            }
+        }
+        if (aborted) {
+            break;
+        }
+        std::copy(stack->currentLines, stack->currentLines + lineCount, stack->completedLines);
+        completedDepth = currentDepth;
+    }
+
+    // Куча нужна только здесь: вектор линий и по вектору на вариант
+    if (completedDepth > 0) {
+        lines.resize(lineCount);
+        for (int line = 0; line < lineCount; ++line) {
+            const RootLine &completed = stack->completedLines[line];
+            SearchResult &result = lines[line];
+            result.score = completed.score;
+            result.depth = completedDepth;
+            result.bestMove = completed.pv[0];
+            result.pv.reserve(completed.pvLength);
+            for (int i = 0; i < completed.pvLength; ++i) {
+                result.pv.append(completed.pv[i]);
+            }
+        }
+    }
+    return lines;
+}
+
+// Поиск в корне среди ходов, начиная с firstMove; предыдущие уже заняты другими линиями
+int ChessAI::searchRoot(int depth, int alpha, int beta, int firstMove)
+{
+    SearchPly &root = stack->plies[0];
+    root.pvLength = 0;
+
+    int bestScore = -INF_SCORE;
+    for (int i = firstMove; i < root.moves.size(); ++i) {
+        const ChessMove &move = root.moves[i];
+        makeSearchMove(0, move);
+        int score;
+        if (i == firstMove) {
+            score = -negamax(1, depth - 1, -beta, -alpha, true);
+        } else {
+            score = -negamax(1, depth - 1, -alpha - 1, -alpha, true);
+            if (score > alpha && score < beta) {
+                score = -negamax(1, depth - 1, -beta, -alpha, true);
+            }
+        }
+        position.unmakeMove(move, root.undo);
+        if (aborted) {
+            return 0;
+        }
 
         if (score > bestScore) {
             bestScore = score;
-            bestMove = move;
+            // При провале вниз ходы не различимы — вариантом остаётся первый ход
+            if (score > alpha || root.pvLength == 0) {
+                updatePv(0, move);
+            }
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) {
+            break;
         }
     }
 
-    return bestMove;
+    return bestScore;
 }
 
-int ChessAI::minimax(ChessBoardData boardData, int depth, int alpha, int beta, bool maximizingPlayer)
+int ChessAI::negamax(int ply, int depth, int alpha, int beta, bool allowNullMove)
 {
-    ChessBoard tempBoard;
-    tempBoard.setBoardData(boardData);
+    SearchPly &node = stack->plies[ply];
+    node.pvLength = 0;
 
-    if (depth == 0 || tempBoard.getGameState() != IN_PROGRESS) {
-        return evaluateBoard(tempBoard.getBoardData());
+    // Повторение или правило 50 ходов: дальше смотреть незачем.
+    // Мат сотым полуходом важнее ничьей, поэтому под шахом проверяем ответы
+    stack->keys[stack->rootIndex + ply] = position.key;
+    if (position.halfmoveClock >= 100) {
+        if (position.isInCheck(position.currentPlayer)) {
+            node.moves.clear();
+            position.generateLegalMoves(position.currentPlayer, node.moves);
+            if (node.moves.isEmpty()) {
+                return -MATE_SCORE + ply;
+            }
+        }
+        return DRAW_SCORE;
+    }
+    // Внутри поиска ничьей считаем уже первое повторение
+    if (position.isRepetition(stack->keys, stack->rootIndex + ply, 1)) {
+        return DRAW_SCORE;
     }
 
-    PieceColor currentColor = maximizingPlayer ? BLACK : WHITE;
-    QVector<ChessMove> moves = getAllPossibleMoves(&boardData, currentColor);
+    if (depth <= 0) {
+        return quiescence(ply, alpha, beta);
+    }
+    if (ply >= MAX_PLY - 1) {
+        return evaluate(ply);
+    }
+    ++nodes;
+    if (isOutOfLimits()) {
+        return 0;
+    }
 
-    if (maximizingPlayer) {
-        int maxEval = std::numeric_limits<int>::min();
-        for (const ChessMove &move : moves) {
-            ChessBoardData newData = boardData;
-            ChessBoard newBoard;
-            newBoard.setBoardData(newData);
-            newBoard.makeMoveForAI(move.fromRow, move.fromCol, move.toRow, move.toCol);
+    PieceColor currentColor = position.currentPlayer;
+    PieceColor opponentColor = (currentColor == WHITE) ? BLACK : WHITE;
+    bool isPvNode = beta - alpha > 1;
 
-            int eval = minimax(newBoard.getBoardData(), depth - 1, alpha, beta, false);
-            maxEval = std::max(maxEval, eval);
-            alpha = std::max(alpha, eval);
+    // Таблица транспозиций: вне главного варианта готовая оценка сразу даёт ответ,
+    // а сохранённый лучший ход в любом случае смотрим первым
+    ChessMove ttMove;
+    if (const TTEntry *entry = table->probe(position.key)) {
+        ttMove = entry->move;
+        int ttScore = scoreFromTable(entry->score, ply);
+        if (!isPvNode && entry->depth >= depth &&
+            (entry->bound == BOUND_EXACT ||
+             (entry->bound == BOUND_LOWER && ttScore >= beta) ||
+             (entry->bound == BOUND_UPPER && ttScore <= alpha))) {
+            return ttScore;
+        }
+    }
+    int originalAlpha = alpha;
 
-            if (beta <= alpha) {
-                break;
+    node.moves.clear();
+    position.generateLegalMoves(currentColor, node.moves);
+
+    bool inCheck = position.isInCheck(currentColor);
+
+    // Нет ходов: мат или пат
+    if (node.moves.isEmpty()) {
+        return inCheck ? -MATE_SCORE + ply : DRAW_SCORE;
+    }
+
+    int staticEval = evaluate(ply);
+
+    // Razoring: позиция настолько плоха, что тихие ходы не спасут — проверяем только взятия
+    if (options.razoring && !isPvNode && !inCheck && depth <= 2 &&
+        staticEval + RAZOR_MARGIN[depth] <= alpha) {
+        int score = quiescence(ply, alpha, beta);
+        if (score <= alpha) {
+            return score;
+        }
+    }
+
+    // Нулевой ход: если даже пропуск хода не опускает оценку ниже beta, отсекаем.
+    // Защита от цугцванга: не под шахом, не два нулевых хода подряд
+    // и не в эндшпиле, где у стороны остались только пешки
+    if (options.nullMove && allowNullMove && !isPvNode && !inCheck && depth >= 3 &&
+        staticEval >= beta && beta < MATE_BOUND && position.hasNonPawnMaterial(currentColor)) {
+        int reduction = depth >= 6 ? 3 : 2;
+        position.makeNullMove(node.undo);
+        if (network) {
+            stack->plies[ply + 1].accumulator = node.accumulator;
+        }
+        int score = -negamax(ply + 1, depth - 1 - reduction, -beta, -beta + 1, false);
+        position.unmakeNullMove(node.undo);
+
+        if (score >= beta) {
+            // На большой глубине подтверждаем обычным поиском без нулевого хода
+            if (depth < 8 || negamax(ply, depth - 1 - reduction, beta - 1, beta, false) >= beta) {
+                return beta;
             }
+            node.moves.clear();
+            position.generateLegalMoves(currentColor, node.moves);
         }
-        return maxEval;
+    }
+
+    // Futility: у самых листьев тихий ход не поднимет оценку выше alpha
+    bool futile = options.futility && !isPvNode && !inCheck && depth <= 2 &&
+                  staticEval + FUTILITY_MARGIN[depth] <= alpha && alpha > -MATE_BOUND;
+
+    scoreMoves(ply, ttMove);
+
+    int bestScore = -INF_SCORE;
+    ChessMove bestMove;
+    int searchedMoves = 0;
+
+    for (int i = 0; i < node.moves.size(); ++i) {
+        const ChessMove &move = pickNextMove(ply, i);
+        bool isQuiet = position.board[move.toRow()][move.toCol()].isEmpty() &&
+                       move.flag() != PROMOTION_MOVE;
+        bool isKiller = move == node.killers[0] || move == node.killers[1];
+        // Взятие, теряющее в размене больше допустимого, у листьев не смотрим
+        bool losingCapture = options.seePruning && !isPvNode && !inCheck && depth <= 3 &&
+                             node.scores[i] < 0 &&
+                             node.scores[i] - BAD_CAPTURE_SCORE < -SEE_PRUNE_MARGIN * depth;
+
+        makeSearchMove(ply, move);
+        bool givesCheck = position.isInCheck(opponentColor);
+
+        if (((futile && isQuiet) || losingCapture) && !givesCheck && searchedMoves > 0) {
+            position.unmakeMove(move, node.undo);
+            continue;
+        }
+
+        int score;
+        if (searchedMoves == 0) {
+            score = -negamax(ply + 1, depth - 1, -beta, -alpha, true);
+        } else {
+            // Late move reductions: поздние тихие ходы сначала смотрим на меньшую глубину
+            int reduction = 0;
+            if (options.lateMoveReductions && depth >= 3 && searchedMoves >= 3 &&
+                isQuiet && !isKiller && !inCheck && !givesCheck) {
+                reduction = (searchedMoves >= 6 && depth >= 6) ? 2 : 1;
+            }
+
+            // PVS: остальные ходы проверяем нулевым окном и пересчитываем, только если они лучше
+            score = -negamax(ply + 1, depth - 1 - reduction, -alpha - 1, -alpha, true);
+            if (score > alpha && reduction > 0) {
+                score = -negamax(ply + 1, depth - 1, -alpha - 1, -alpha, true);
+            }
+            if (score > alpha && score < beta) {
+                score = -negamax(ply + 1, depth - 1, -beta, -alpha, true);
+            }
+        }
+        position.unmakeMove(move, node.undo);
+        if (aborted) {
+            return 0;
+        }
+        ++searchedMoves;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                bestMove = move;
+                updatePv(ply, move);
+            }
+        }
+
+        if (alpha >= beta) {
+            if (isQuiet) {
+                storeKiller(ply, move);
+            }
+            break;
+        }
+    }
+
+    TTBound bound = bestScore >= beta ? BOUND_LOWER
+                  : (bestScore > originalAlpha ? BOUND_EXACT : BOUND_UPPER);
+    table->store(position.key, depth, scoreToTable(bestScore, ply), bound, bestMove);
+    return bestScore;
+}
+
+int ChessAI::quiescence(int ply, int alpha, int beta)
+{
+    stack->plies[ply].pvLength = 0;
+    ++nodes;
+    if (isOutOfLimits()) {
+        return 0;
+    }
+
+    PieceColor currentColor = position.currentPlayer;
+    bool inCheck = position.isInCheck(currentColor);
+    int standPat = evaluate(ply);
+
+    if (ply >= MAX_PLY - 1) {
+        return standPat;
+    }
+
+    // Под шахом «стоять» нельзя: смотрим все ответы, а не только взятия
+    SearchPly &node = stack->plies[ply];
+    node.moves.clear();
+    position.generateLegalMoves(currentColor, node.moves, !inCheck);
+
+    int bestScore;
+    if (inCheck) {
+        if (node.moves.isEmpty()) {
+            return -MATE_SCORE + ply;
+        }
+        bestScore = -INF_SCORE;
     } else {
-        int minEval = std::numeric_limits<int>::max();
-        for (const ChessMove &move : moves) {
-            ChessBoardData newData = boardData;
-            ChessBoard newBoard;
-            newBoard.setBoardData(newData);
-            newBoard.makeMoveForAI(move.fromRow, move.fromCol, move.toRow, move.toCol);
-
-            int eval = minimax(newBoard.getBoardData(), depth - 1, alpha, beta, true);
-            minEval = std::min(minEval, eval);
-            beta = std::min(beta, eval);
-
-            if (beta <= alpha) {
-                break;
+        if (standPat >= beta) {
+            return standPat;
+        }
+        bestScore = standPat;
+        alpha = std::max(alpha, standPat);
+    }
+
+    scoreMoves(ply);
+
+    for (int i = 0; i < node.moves.size(); ++i) {
+        const ChessMove &move = pickNextMove(ply, i);
+        // Ходы отсортированы: дальше только взятия, проигрывающие размен
+        if (options.seePruning && !inCheck && node.scores[i] < 0) {
+            break;
+        }
+        makeSearchMove(ply, move);
+        int score = -quiescence(ply + 1, -beta, -alpha);
+        position.unmakeMove(move, node.undo);
+        if (aborted) {
+            return 0;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                updatePv(ply, move);
+            }
+        }
+        if (alpha >= beta) {
+            break;
+        }
+    }
+
+    return bestScore;
+}
+
+void ChessAI::updatePv(int ply, const ChessMove &move)
+{
+    SearchPly &node = stack->plies[ply];
+    const SearchPly &child = stack->plies[ply + 1];
+    node.pv[0] = move;
+    for (int i = 0; i < child.pvLength; ++i) {
+        node.pv[i + 1] = child.pv[i];
+    }
+    node.pvLength = child.pvLength + 1;
+}
+
+bool ChessAI::isOutOfLimits()
+{
+    // Таймер опрашиваем раз в 1024 узла: сам вызов дороже узла
+    if (!aborted && abortAllowed) {
+        aborted = (limits.nodes > 0 && nodes >= limits.nodes) ||
+                  (limits.timeMs > 0 && (nodes & 1023) == 0 && timer.elapsed() >= limits.timeMs);
+    }
+    return aborted;
+}
+
+// Аккумулятор сети считается до хода: нужны снятые с доски фигуры
+void ChessAI::makeSearchMove(int ply, const ChessMove &move)
+{
+    SearchPly &node = stack->plies[ply];
+    if (network) {
+        network->update(node.accumulator, stack->plies[ply + 1].accumulator, position, move);
+    }
+    position.makeMove(move, node.undo);
+}
+
+// Оценка с точки зрения стороны, которая ходит
+int ChessAI::evaluate(int ply)
+{
+    if (network) {
+        return network->evaluate(stack->plies[ply].accumulator, position.currentPlayer);
+    }
+
+    int score = evaluateBoard(position);
+    return position.currentPlayer == BLACK ? score : -score;
+}
+
+void ChessAI::scoreMoves(int ply, const ChessMove &ttMove)
+{
+    SearchPly &node = stack->plies[ply];
+    for (int i = 0; i < node.moves.size(); ++i) {
+        const ChessMove &move = node.moves[i];
+        const ChessPiece &victim = position.board[move.toRow()][move.toCol()];
+        int score = 0;
+        if (move == ttMove) {
+            score = TT_MOVE_SCORE;
+        } else if (!victim.isEmpty() || move.flag() == PROMOTION_MOVE) {
+            // Взятия и превращения сначала проверяем разменом на клетке
+            int exchange = position.staticExchange(move);
+            if (exchange < 0) {
+                score = BAD_CAPTURE_SCORE + exchange;
+            } else {
+                const ChessPiece &attacker = position.board[move.fromRow()][move.fromCol()];
+                score = GOOD_CAPTURE_SCORE + 10 * ORDER_VALUES[victim.type()] - ORDER_VALUES[attacker.type()];
+                if (move.flag() == PROMOTION_MOVE) {
+                    score += 10000;
+                }
             }
+        } else if (move == node.killers[0]) {
+            score = KILLER_SCORE;
+        } else if (move == node.killers[1]) {
+            score = KILLER_SCORE - 1;
         }
-        return minEval;
+        node.scores[i] = score;
+    }
+}
+
+const ChessMove &ChessAI::pickNextMove(int ply, int index)
+{
+    // Выборочная сортировка: на отсечении остальные ходы сортировать не нужно
+    SearchPly &node = stack->plies[ply];
+    int best = index;
+    for (int i = index + 1; i < node.moves.size(); ++i) {
+        if (node.scores[i] > node.scores[best]) {
+            best = i;
+        }
+    }
+    std::swap(node.moves[index], node.moves[best]);
+    std::swap(node.scores[index], node.scores[best]);
+    return node.moves[index];
+}
+
+void ChessAI::storeKiller(int ply, const ChessMove &move)
+{
+    SearchPly &node = stack->plies[ply];
+    if (move != node.killers[0]) {
+        node.killers[1] = node.killers[0];
+        node.killers[0] = move;
     }
 }
 
@@ -105,10 +599,10 @@ int ChessAI::evaluateBoard(const ChessBoardData &boardData)
     // Подсчет материала
     for (int row = 0; row < 8; ++row) {
         for (int col = 0; col < 8; ++col) {
-            ChessPiece piece = boardData.board[row][col];
+            const ChessPiece &piece = boardData.board[row][col];
             int value = 0;
 
-            switch (piece.type) {
+            switch (piece.type()) {
             case PAWN:   value = pawnValue; break;
             case KNIGHT: value = knightValue; break;
             case BISHOP: value = bishopValue; break;
@@ -118,9 +612,9 @@ int ChessAI::evaluateBoard(const ChessBoardData &boardData)
             default:     value = 0;
             }
 
-            if (piece.color == WHITE) {
+            if (piece.color() == WHITE) {
                 score -= value;
-            } else if (piece.color == BLACK) {
+            } else if (piece.color() == BLACK) {
                 score += value;
             }
         }
@@ -130,46 +624,16 @@ int ChessAI::evaluateBoard(const ChessBoardData &boardData)
     int centerBonus = 0;
     for (int row = 3; row <= 4; ++row) {
         for (int col = 3; col <= 4; ++col) {
-            ChessPiece piece = boardData.board[row][col];
-            if (piece.type == PAWN) {
-                if (piece.color == BLACK) centerBonus += 10;
+            const ChessPiece &piece = boardData.board[row][col];
+            if (piece.type() == PAWN) {
+                if (piece.color() == BLACK) centerBonus += 10;
                 else centerBonus -= 10;
             }
         }
     }
     score += centerBonus;
 
-    // Проверяем состояние игры
-    ChessBoard tempBoard;
-    tempBoard.setBoardData(boardData);
-
-    if (tempBoard.getGameState() == BLACK_WIN) {
-        score += 10000;
-    } else if (tempBoard.getGameState() == WHITE_WIN) {
-        score -= 10000;
-    }
-
+    // Мат и пат определяет minimax по отсутствию ходов,
+    // поэтому временная ChessBoard здесь больше не нужна
     return score;
 }
-
-QVector<ChessMove> ChessAI::getAllPossibleMoves(const ChessBoardData *boardData, PieceColor color)
-{
-    QVector<ChessMove> moves;
-
-    ChessBoard tempBoard;
-    tempBoard.setBoardData(*boardData);
-
-    for (int fromRow = 0; fromRow < 8; ++fromRow) {
-        for (int fromCol = 0; fromCol < 8; ++fromCol) {
-            ChessPiece piece = boardData->board[fromRow][fromCol];
-            if (piece.color == color) {
-                QVector<QPair<int, int>> validMoves = tempBoard.getValidMoves(fromRow, fromCol);
-                for (const auto &move : validMoves) {
-                    moves.append(ChessMove(fromRow, fromCol, move.first, move.second));
-                }
-            }
-        }
-    }
-
-    return moves;
-}
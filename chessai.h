@@ -2,19 +2,85 @@
 #define CHESSAI_H
 
 #include "chessboard.h"
+#include "nnue.h"
+#include "transpositiontable.h"
+#include <QElapsedTimer>
 #include <QObject>
+#include <QScopedPointer>
 #include <QVector>
 
-struct ChessMove {
-    int fromRow;
-    int fromCol;
-    int toRow;
-    int toCol;
+const int MAX_PLY = 64;
+// Сколько позиций партии перед корнем нужно для поиска повторений:
+// дальше последнего необратимого хода (не больше 100 полуходов) смотреть незачем
+const int MAX_HISTORY = 128;
+// Таблица транспозиций на экземпляр ChessAI по умолчанию
+const int DEFAULT_TT_SIZE_MB = 16;
+
+// Отсечения и сокращения включаются по отдельности,
+// чтобы можно было измерить вклад каждого из них
+struct SearchOptions {
+    bool nullMove;
+    bool lateMoveReductions;
+    bool futility;
+    bool razoring;
+    bool aspirationWindows;
+    bool seePruning; // отбрасывать проигрывающие размен взятия (SEE < 0)
+
+    SearchOptions()
+        : nullMove(true), lateMoveReductions(true), futility(true),
+          razoring(true), aspirationWindows(true), seePruning(true) {}
+};
+
+// Ограничения поиска. Нулевые nodes и timeMs — без ограничения.
+// Прерванная итерация отбрасывается, первая итерация доигрывается всегда
+struct SearchLimits {
+    int depth;
+    quint64 nodes;
+    qint64 timeMs;
+
+    SearchLimits() : depth(MAX_PLY - 1), nodes(0), timeMs(0) {}
+};
+
+// Данные одного уровня поиска
+struct SearchPly {
+    MoveList moves;
+    int scores[MAX_MOVES]; // оценки для упорядочивания, параллельно moves
+    MoveUndo undo;
+    ChessMove killers[2];
+    NnueAccumulator accumulator; // первый слой сети для позиции этого уровня
+    // Строка треугольной таблицы главного варианта: лучшее продолжение с этого уровня
+    ChessMove pv[MAX_PLY];
+    int pvLength;
+};
+
+// Линия корня в multi-PV: вариант и оценка с последней итерации углубления
+struct RootLine {
+    ChessMove pv[MAX_PLY];
+    int pvLength;
+    int score;
+};
+
+// Арена поиска: выделяется один раз на экземпляр ChessAI (то есть на поток поиска),
+// от входа в поиск до сборки результата обращений к куче нет
+struct SearchStack {
+    SearchPly plies[MAX_PLY];
+    // Линии текущей итерации и последней доигранной
+    RootLine currentLines[MAX_MOVES];
+    RootLine completedLines[MAX_MOVES];
+    // Ключи позиций: хвост партии, затем текущий путь поиска (keys[rootIndex + ply])
+    quint64 keys[MAX_HISTORY + MAX_PLY];
+    int rootIndex;
+};
+
+// Результат поиска: оценка с точки зрения стороны, которая ходит в корне,
+// и главный вариант, начинающийся с лучшего хода
+struct SearchResult {
+    ChessMove bestMove;
     int score;
+    int depth;
+    QVector<ChessMove> pv;
 
-    ChessMove() : fromRow(-1), fromCol(-1), toRow(-1), toCol(-1), score(0) {}
-    ChessMove(int fr, int fc, int tr, int tc, int s = 0)
-        : fromRow(fr), fromCol(fc), toRow(tr), toCol(tc), score(s) {}
+    SearchResult() : score(0), depth(0) {}
 };
 
 class ChessAI : public QObject
@@ -23,13 +89,50 @@ class ChessAI : public QObject
 
 public:
     ChessAI(ChessBoard *board, QObject *parent = nullptr);
-    ChessMove findBestMove(int depth);
-    QVector<ChessMove> getAllPossibleMoves(const ChessBoardData *boardData, PieceColor color);
+    ~ChessAI();
+    SearchResult findBestMove(int depth);
+    // Поиск в произвольной позиции без ChessBoard; history — ключи предыдущих позиций партии
+    SearchResult findBestMove(const ChessBoardData &boardData, const QVector<quint64> &history,
+                              const SearchLimits &searchLimits);
+    // Multi-PV: lineCount лучших ходов корня, у каждого точная оценка, глубина и вариант.
+    // Линии отсортированы от лучшей; таблица транспозиций общая для всех линий
+    QVector<SearchResult> findBestMoves(int depth, int lineCount);
+    QVector<SearchResult> findBestMoves(const ChessBoardData &boardData, const QVector<quint64> &history,
+                                        const SearchLimits &searchLimits, int lineCount);
+    void setSearchOptions(const SearchOptions &newOptions) { options = newOptions; }
+    SearchOptions searchOptions() const { return options; }
+    quint64 searchedNodes() const { return nodes; }
+    // Оценка сетью вместо evaluateBoard; nullptr — обычная оценка.
+    // Сеть не копируется и должна жить дольше ChessAI
+    void setNetwork(const NnueNetwork *newNetwork) { network = newNetwork; }
+    // Новая пустая таблица; при многих экземплярах в потоках её стоит уменьшить
+    void setTranspositionTableSize(int megabytes);
+    // Забыть прошлые поиски, например перед новой партией
+    void clearTranspositionTable() { table->clear(); }
 private:
     ChessBoard *chessBoard;
+    ChessBoardData position;
+    QScopedPointer<SearchStack> stack;
+    QScopedPointer<TranspositionTable> table;
+    SearchOptions options;
+    const NnueNetwork *network;
+    quint64 nodes;
+    SearchLimits limits;
+    QElapsedTimer timer;
+    bool abortAllowed;
+    bool aborted;
 
-    int minimax(ChessBoardData boardData, int depth, int alpha, int beta, bool maximizingPlayer);
+    int searchRoot(int depth, int alpha, int beta, int firstMove);
+    int negamax(int ply, int depth, int alpha, int beta, bool allowNullMove);
+    int quiescence(int ply, int alpha, int beta);
+    void makeSearchMove(int ply, const ChessMove &move);
+    int evaluate(int ply);
     int evaluateBoard(const ChessBoardData &boardData);
+    void updatePv(int ply, const ChessMove &move);
+    bool isOutOfLimits();
+    void scoreMoves(int ply, const ChessMove &ttMove = ChessMove());
+    const ChessMove &pickNextMove(int ply, int index);
+    void storeKiller(int ply, const ChessMove &move);
 
 };
 
@@ -1,10 +1,81 @@
 #include "chessboard.h"
 #include <QPainter>
 #include <QGraphicsSceneMouseEvent>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
 #include <QDebug>
+#include <QStringList>
+
+namespace {
+
+// Случайные ключи Zobrist; генерируются при компиляции (splitmix64)
+struct ZobristKeys {
+    quint64 pieces[2][7][64];
+    quint64 side;
+    quint64 castling[16];
+};
+
+constexpr quint64 splitMix64(quint64 &state)
+{
+    quint64 z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys()
+{
+    ZobristKeys keys = {};
+    quint64 state = 0x2545F4914F6CDD1DULL;
+    for (int color = 0; color < 2; ++color) {
+        for (int type = PAWN; type <= KING; ++type) {
+            for (int square = 0; square < 64; ++square) {
+                keys.pieces[color][type][square] = splitMix64(state);
+            }
+        }
+    }
+    keys.side = splitMix64(state);
+    for (int rights = 1; rights < 16; ++rights) {
+        keys.castling[rights] = splitMix64(state);
+    }
+    return keys;
+}
+
+constexpr ZobristKeys ZOBRIST = makeZobristKeys();
+
+// Стоимость фигур для размена; совпадает с весами оценки ИИ
+const int SEE_VALUES[] = { 0, 100, 320, 330, 500, 900, 20000 };
+
+// Права на рокировку, которые остаются после хода с клетки или на клетку
+quint8 castlingRightsKept(int square)
+{
+    switch (square) {
+    case 0:  return ALL_CASTLING & ~BLACK_QUEENSIDE;                  // a8
+    case 4:  return ALL_CASTLING & ~(BLACK_KINGSIDE | BLACK_QUEENSIDE); // e8
+    case 7:  return ALL_CASTLING & ~BLACK_KINGSIDE;                   // h8
+    case 56: return ALL_CASTLING & ~WHITE_QUEENSIDE;                  // a1
+    case 60: return ALL_CASTLING & ~(WHITE_KINGSIDE | WHITE_QUEENSIDE); // e1
+    case 63: return ALL_CASTLING & ~WHITE_KINGSIDE;                   // h1
+    default: return ALL_CASTLING;
+    }
+}
+
+}
+
+// Реализация ChessMove
+QString ChessMove::toString() const
+{
+    char text[5] = {
+        char('a' + fromCol()), char('8' - fromRow()),
+        char('a' + toCol()), char('8' - toRow()),
+        flag() == PROMOTION_MOVE ? "nbrq"[promotion() - KNIGHT] : '\0'
+    };
+    return QString::fromLatin1(text, text[4] ? 5 : 4);
+}
 
 // Реализация ChessBoardData
-ChessBoardData::ChessBoardData() : currentPlayer(WHITE), gameState(IN_PROGRESS)
+ChessBoardData::ChessBoardData()
+    : currentPlayer(WHITE), gameState(IN_PROGRESS), castlingRights(ALL_CASTLING), halfmoveClock(0), key(0)
 {
     reset();
 }
@@ -45,142 +116,273 @@ void ChessBoardData::reset()
 
     currentPlayer = WHITE;
     gameState = IN_PROGRESS;
+    castlingRights = ALL_CASTLING;
+    halfmoveClock = 0;
+    refreshBitboards();
 }
 
-void ChessBoardData::copyFrom(const ChessBoardData &other)
+bool ChessBoardData::loadFen(const QString &fen)
 {
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            board[i][j] = other.board[i][j];
+    const QStringList fields = fen.simplified().split(QLatin1Char(' '));
+    if (fields.size() < 2) {
+        return false;
+    }
+
+    ChessPiece parsed[8][8];
+    int row = 0;
+    int col = 0;
+    for (QChar ch : fields[0]) {
+        char c = ch.toLatin1();
+        if (c == '/') {
+            if (col != 8 || ++row > 7) {
+                return false;
+            }
+            col = 0;
+        } else if (c >= '1' && c <= '8') {
+            col += c - '0';
+            if (col > 8) {
+                return false;
+            }
+        } else {
+            int index = QStringLiteral("pnbrqk").indexOf(ch.toLower());
+            if (index < 0 || col > 7) {
+                return false;
+            }
+            PieceType type = PieceType(PAWN + index);
+            parsed[row][col++] = ChessPiece(type, ch.isUpper() ? WHITE : BLACK);
         }
     }
-    currentPlayer = other.currentPlayer;
-    gameState = other.gameState;
-}
+    if (row != 7 || col != 8) {
+        return false;
+    }
 
-// Реализация ChessBoard
-ChessBoard::ChessBoard(QObject *parent)
-    : QObject(parent), selectedRow(-1), selectedCol(-1), pieceSelected(false)
-{
-    setFlag(QGraphicsItem::ItemIsFocusable);
-    resetBoard();
-}
+    PieceColor side;
+    if (fields[1] == QLatin1String("w")) {
+        side = WHITE;
+    } else if (fields[1] == QLatin1String("b")) {
+        side = BLACK;
+    } else {
+        return false;
+    }
 
-ChessBoard::~ChessBoard()
-{
-}
+    quint8 rights = 0;
+    if (fields.size() > 2) {
+        for (QChar ch : fields[2]) {
+            switch (ch.toLatin1()) {
+            case 'K': rights |= WHITE_KINGSIDE; break;
+            case 'Q': rights |= WHITE_QUEENSIDE; break;
+            case 'k': rights |= BLACK_KINGSIDE; break;
+            case 'q': rights |= BLACK_QUEENSIDE; break;
+            case '-': break;
+            default: return false;
+            }
+        }
+    }
 
-QRectF ChessBoard::boundingRect() const
-{
-    return QRectF(0, 0, 520, 520);
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            board[i][j] = parsed[i][j];
+        }
+    }
+    currentPlayer = side;
+    castlingRights = rights;
+    halfmoveClock = fields.size() > 4 ? fields[4].toInt() : 0;
+    refreshBitboards();
+    updateGameState();
+    return true;
 }
 
-void ChessBoard::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+QString ChessBoardData::toFen() const
 {
-    Q_UNUSED(option);
-    Q_UNUSED(widget);
-
-    // Рисуем доску
+    QString fen;
     for (int row = 0; row < 8; ++row) {
+        int empty = 0;
         for (int col = 0; col < 8; ++col) {
-            QRectF rect(col * 65, row * 65, 65, 65);
-
-            // Чередуем цвета клеток
-            if ((row + col) % 2 == 0) {
-                painter->fillRect(rect, QColor(240, 217, 181)); // Светлая клетка
-            } else {
-                painter->fillRect(rect, QColor(181, 136, 99)); // Темная клетка
+            const ChessPiece &piece = board[row][col];
+            if (piece.isEmpty()) {
+                ++empty;
+                continue;
             }
-
-            // Подсвечиваем выбранную клетку
-            if (pieceSelected && selectedRow == row && selectedCol == col) {
-                painter->fillRect(rect, QColor(255, 255, 0, 100));
+            if (empty) {
+                fen += QString::number(empty);
+                empty = 0;
             }
+            char letter = " pnbrqk"[piece.type()];
+            fen += QLatin1Char(piece.color() == WHITE ? char(letter - 'a' + 'A') : letter);
+        }
+        if (empty) {
+            fen += QString::number(empty);
+        }
+        if (row < 7) {
+            fen += QLatin1Char('/');
+        }
+    }
 
-            // Рисуем фигуру
-            if (data.board[row][col].type != NO_PIECE) {
-                drawPiece(painter, data.board[row][col].type, data.board[row][col].color, rect);
-            }
+    fen += currentPlayer == WHITE ? QLatin1String(" w ") : QLatin1String(" b ");
+    const char rightLetters[] = "KQkq";
+    bool anyRights = false;
+    for (int i = 0; i < 4; ++i) {
+        if (castlingRights & (1 << i)) {
+            fen += QLatin1Char(rightLetters[i]);
+            anyRights = true;
         }
     }
+    if (!anyRights) {
+        fen += QLatin1Char('-');
+    }
+    fen += QString(" - %1 1").arg(halfmoveClock);
+    return fen;
 }
 
-void ChessBoard::drawPiece(QPainter *painter, PieceType type, PieceColor color, const QRectF &rect)
+void ChessBoardData::copyFrom(const ChessBoardData &other)
 {
-    QString pieceChar;
-    QColor pieceColor = (color == WHITE) ? Qt::white : Qt::black;
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            board[i][j] = other.board[i][j];
+        }
+    }
+    currentPlayer = other.currentPlayer;
+    gameState = other.gameState;
+    castlingRights = other.castlingRights;
+    halfmoveClock = other.halfmoveClock;
+    key = other.key;
+    for (int i = 0; i < 2; ++i) {
+        byColor[i] = other.byColor[i];
+    }
+    for (int i = 0; i < 7; ++i) {
+        byType[i] = other.byType[i];
+    }
+}
 
-    switch (type) {
-    case PAWN:   pieceChar = "♙"; break;
-    case KNIGHT: pieceChar = "♘"; break;
-    case BISHOP: pieceChar = "♗"; break;
-    case ROOK:   pieceChar = "♖"; break;
-    case QUEEN:  pieceChar = "♕"; break;
-    case KING:   pieceChar = "♔"; break;
-    default:     return;
+void ChessBoardData::refreshBitboards()
+{
+    byColor[WHITE] = byColor[BLACK] = 0;
+    for (int i = 0; i < 7; ++i) {
+        byType[i] = 0;
     }
+    key = ZOBRIST.castling[castlingRights];
+    if (currentPlayer == BLACK) {
+        key ^= ZOBRIST.side;
+    }
+    for (int square = 0; square < 64; ++square) {
+        const ChessPiece &piece = board[square / 8][square % 8];
+        if (!piece.isEmpty()) {
+            byColor[piece.color()] |= Bitboards::squareBit(square);
+            byType[piece.type()] |= Bitboards::squareBit(square);
+            key ^= ZOBRIST.pieces[piece.color()][piece.type()][square];
+        }
+    }
+}
 
-    painter->setFont(QFont("Arial", 40));
-    painter->setPen(pieceColor);
-    painter->drawText(rect, Qt::AlignCenter, pieceChar);
+void ChessBoardData::putPiece(int square, ChessPiece piece)
+{
+    board[square / 8][square % 8] = piece;
+    byColor[piece.color()] |= Bitboards::squareBit(square);
+    byType[piece.type()] |= Bitboards::squareBit(square);
+    key ^= ZOBRIST.pieces[piece.color()][piece.type()][square];
 }
 
-void ChessBoard::resetBoard()
+void ChessBoardData::removePiece(int square)
 {
-    data.reset();
-    pieceSelected = false;
-    update();
-    emit gameStateChanged();
+    ChessPiece &piece = board[square / 8][square % 8];
+    if (piece.isEmpty()) {
+        return;
+    }
+    byColor[piece.color()] &= ~Bitboards::squareBit(square);
+    byType[piece.type()] &= ~Bitboards::squareBit(square);
+    key ^= ZOBRIST.pieces[piece.color()][piece.type()][square];
+    piece = ChessPiece();
 }
 
-void ChessBoard::setBoardData(const ChessBoardData &newData)
+int ChessBoardData::kingSquare(PieceColor color) const
 {
-    data.copyFrom(newData);
-    update();
-    emit gameStateChanged();
+    Bitboard king = pieces(color, KING);
+    return king ? Bitboards::lsb(king) : -1;
 }
 
-bool ChessBoard::makeMove(int fromRow, int fromCol, int toRow, int toCol)
+Bitboard ChessBoardData::attackersTo(int square, Bitboard occupancy) const
 {
-    if (!isValidMove(fromRow, fromCol, toRow, toCol)) {
-        return false;
+    using namespace Bitboards;
+    return (pawnAttacks(BLACK, square) & pieces(WHITE, PAWN)) |
+           (pawnAttacks(WHITE, square) & pieces(BLACK, PAWN)) |
+           (knightAttacks(square) & byType[KNIGHT]) |
+           (kingAttacks(square) & byType[KING]) |
+           (bishopAttacks(square, occupancy) & (byType[BISHOP] | byType[QUEEN])) |
+           (rookAttacks(square, occupancy) & (byType[ROOK] | byType[QUEEN]));
+}
+
+int ChessBoardData::staticExchange(const ChessMove &move) const
+{
+    using namespace Bitboards;
+
+    int from = move.from();
+    int to = move.to();
+    PieceColor side = board[from / 8][from % 8].color();
+    PieceType attacker = board[from / 8][from % 8].type();
+
+    // gain[d] — выигрыш стороны, взявшей на глубине d, если размен на этом остановится
+    int gain[32];
+    int depth = 0;
+    gain[0] = SEE_VALUES[board[to / 8][to % 8].type()];
+    if (move.flag() == PROMOTION_MOVE) {
+        gain[0] += SEE_VALUES[move.promotion()] - SEE_VALUES[PAWN];
+        attacker = move.promotion();
     }
 
-    // Выполняем ход
-    data.board[toRow][toCol] = data.board[fromRow][fromCol];
-    data.board[fromRow][fromCol] = ChessPiece();
-    data.board[toRow][toCol].hasMoved = true;
+    Bitboard occupancy = occupied() ^ squareBit(from);
+    Bitboard attackers = attackersTo(to, occupancy) & occupancy;
+    Bitboard diagonalSliders = byType[BISHOP] | byType[QUEEN];
+    Bitboard straightSliders = byType[ROOK] | byType[QUEEN];
 
-    // Превращение пешки
-    if (data.board[toRow][toCol].type == PAWN && (toRow == 0 || toRow == 7)) {
-        data.board[toRow][toCol].type = QUEEN;
-    }
+    while (true) {
+        side = (side == WHITE) ? BLACK : WHITE;
+        Bitboard sideAttackers = attackers & byColor[side];
+        if (!sideAttackers) {
+            break;
+        }
 
-    switchPlayer();
-    updateGameState();
-    update();
-    emit gameStateChanged();
+        // Бьём самой дешёвой фигурой
+        PieceType type = PAWN;
+        while (!(sideAttackers & byType[type])) {
+            type = PieceType(type + 1);
+        }
+        // Король не может брать на защищённой клетке
+        PieceColor opponent = (side == WHITE) ? BLACK : WHITE;
+        if (type == KING && (attackers & byColor[opponent])) {
+            break;
+        }
 
-    return true;
-}
+        // Досрочно не выходим: размер итога нужен для упорядочивания и порога отсечения,
+        // а не только его знак. Каждая сторона может остановиться, это учтёт обратный проход
+        ++depth;
+        gain[depth] = SEE_VALUES[attacker] - gain[depth - 1];
+        if (depth == 31) {
+            break;
+        }
 
-void ChessBoard::makeMoveForAI(int fromRow, int fromCol, int toRow, int toCol)
-{
-    data.board[toRow][toCol] = data.board[fromRow][fromCol];
-    data.board[fromRow][fromCol] = ChessPiece();
-    data.board[toRow][toCol].hasMoved = true;
+        Bitboard fromBit = sideAttackers & byType[type];
+        fromBit &= ~fromBit + 1;
+        occupancy ^= fromBit;
 
-    if (data.board[toRow][toCol].type == PAWN && (toRow == 0 || toRow == 7)) {
-        data.board[toRow][toCol].type = QUEEN;
+        // Рентген: за ушедшей фигурой могут открыться дальнобойные
+        if (type == PAWN || type == BISHOP || type == QUEEN) {
+            attackers |= bishopAttacks(to, occupancy) & diagonalSliders;
+        }
+        if (type == ROOK || type == QUEEN) {
+            attackers |= rookAttacks(to, occupancy) & straightSliders;
+        }
+        attackers &= occupancy;
+        attacker = type;
     }
 
-    switchPlayer();
-    updateGameState();
-    update();
-    emit gameStateChanged();
+    while (depth > 0) {
+        gain[depth - 1] = -qMax(-gain[depth - 1], gain[depth]);
+        --depth;
+    }
+    return gain[0];
 }
 
-bool ChessBoard::isValidMove(int fromRow, int fromCol, int toRow, int toCol) const
+bool ChessBoardData::isPseudoLegal(int fromRow, int fromCol, int toRow, int toCol) const
 {
     // Проверяем базовые условия
     if (fromRow < 0 || fromRow > 7 || fromCol < 0 || fromCol > 7 ||
@@ -188,26 +390,21 @@ bool ChessBoard::isValidMove(int fromRow, int fromCol, int toRow, int toCol) con
         return false;
     }
 
-    const ChessPiece &fromPiece = data.board[fromRow][fromCol];
-    const ChessPiece &toPiece = data.board[toRow][toCol];
+    const ChessPiece &fromPiece = board[fromRow][fromCol];
+    const ChessPiece &toPiece = board[toRow][toCol];
 
     // Нельзя ходить пустой клеткой
-    if (fromPiece.type == NO_PIECE) {
-        return false;
-    }
-
-    // Нельзя ходить не своим цветом
-    if (fromPiece.color != data.currentPlayer) {
+    if (fromPiece.type() == NO_PIECE) {
         return false;
     }
 
     // Нельзя бить свои фигуры
-    if (toPiece.type != NO_PIECE && toPiece.color == fromPiece.color) {
+    if (toPiece.type() != NO_PIECE && toPiece.color() == fromPiece.color()) {
         return false;
     }
 
     // Проверяем правила движения для каждой фигуры
-    switch (fromPiece.type) {
+    switch (fromPiece.type()) {
     case PAWN:   return isValidPawnMove(fromRow, fromCol, toRow, toCol);
     case KNIGHT: return isValidKnightMove(fromRow, fromCol, toRow, toCol);
     case BISHOP: return isValidBishopMove(fromRow, fromCol, toRow, toCol);
@@ -218,200 +415,556 @@ bool ChessBoard::isValidMove(int fromRow, int fromCol, int toRow, int toCol) con
     }
 }
 
+bool ChessBoardData::isValidMove(int fromRow, int fromCol, int toRow, int toCol) const
+{
+    if (!isPseudoLegal(fromRow, fromCol, toRow, toCol)) {
+        return false;
+    }
+
+    // Нельзя ходить не своим цветом
+    return board[fromRow][fromCol].color() == currentPlayer;
+}
+
 // Реализации функций проверки ходов для каждой фигуры
-bool ChessBoard::isValidPawnMove(int fromRow, int fromCol, int toRow, int toCol) const
+bool ChessBoardData::isValidPawnMove(int fromRow, int fromCol, int toRow, int toCol) const
 {
-    const ChessPiece &fromPiece = data.board[fromRow][fromCol];
-    const ChessPiece &toPiece = data.board[toRow][toCol];
-    int direction = (fromPiece.color == WHITE) ? -1 : 1;
+    const ChessPiece &fromPiece = board[fromRow][fromCol];
+    const ChessPiece &toPiece = board[toRow][toCol];
+    int direction = (fromPiece.color() == WHITE) ? -1 : 1;
 
     // Обычный ход вперед
-    if (fromCol == toCol && toPiece.type == NO_PIECE) {
+    if (fromCol == toCol && toPiece.type() == NO_PIECE) {
         if (toRow == fromRow + direction) {
             return true;
         }
-        // Двойной ход из начальной позиции
-        if (!fromPiece.hasMoved && toRow == fromRow + 2 * direction &&
-            data.board[fromRow + direction][fromCol].type == NO_PIECE) {
+        // Двойной ход из начальной позиции: пешка не может вернуться на свою
+        // начальную горизонталь, поэтому признак «ходила» не нужен
+        int startRow = (fromPiece.color() == WHITE) ? 6 : 1;
+        if (fromRow == startRow && toRow == fromRow + 2 * direction &&
+            board[fromRow + direction][fromCol].type() == NO_PIECE) {
             return true;
         }
     }
 
     // Взятие
     if (abs(fromCol - toCol) == 1 && toRow == fromRow + direction &&
-        toPiece.type != NO_PIECE && toPiece.color != fromPiece.color) {
+        toPiece.type() != NO_PIECE && toPiece.color() != fromPiece.color()) {
         return true;
     }
 
     return false;
 }
 
-bool ChessBoard::isValidKnightMove(int fromRow, int fromCol, int toRow, int toCol) const
+bool ChessBoardData::isValidKnightMove(int fromRow, int fromCol, int toRow, int toCol) const
 {
-    int rowDiff = abs(fromRow - toRow);
-    int colDiff = abs(fromCol - toCol);
-    return (rowDiff == 2 && colDiff == 1) || (rowDiff == 1 && colDiff == 2);
+    return Bitboards::knightAttacks(fromRow * 8 + fromCol) & Bitboards::squareBit(toRow * 8 + toCol);
 }
 
-bool ChessBoard::isValidBishopMove(int fromRow, int fromCol, int toRow, int toCol) const
+bool ChessBoardData::isValidBishopMove(int fromRow, int fromCol, int toRow, int toCol) const
 {
-    if (abs(fromRow - toRow) != abs(fromCol - toCol)) {
-        return false;
-    }
-    return isPathClear(fromRow, fromCol, toRow, toCol);
+    return Bitboards::bishopAttacks(fromRow * 8 + fromCol, occupied()) & Bitboards::squareBit(toRow * 8 + toCol);
 }
 
-bool ChessBoard::isValidRookMove(int fromRow, int fromCol, int toRow, int toCol) const
+bool ChessBoardData::isValidRookMove(int fromRow, int fromCol, int toRow, int toCol) const
 {
-    if (fromRow != toRow && fromCol != toCol) {
-        return false;
-    }
-    return isPathClear(fromRow, fromCol, toRow, toCol);
+    return Bitboards::rookAttacks(fromRow * 8 + fromCol, occupied()) & Bitboards::squareBit(toRow * 8 + toCol);
 }
 
-bool ChessBoard::isValidQueenMove(int fromRow, int fromCol, int toRow, int toCol) const
+bool ChessBoardData::isValidQueenMove(int fromRow, int fromCol, int toRow, int toCol) const
 {
     return isValidBishopMove(fromRow, fromCol, toRow, toCol) ||
            isValidRookMove(fromRow, fromCol, toRow, toCol);
 }
 
-bool ChessBoard::isValidKingMove(int fromRow, int fromCol, int toRow, int toCol) const
+bool ChessBoardData::isValidKingMove(int fromRow, int fromCol, int toRow, int toCol) const
 {
-    int rowDiff = abs(fromRow - toRow);
-    int colDiff = abs(fromCol - toCol);
-    return rowDiff <= 1 && colDiff <= 1;
+    return Bitboards::kingAttacks(fromRow * 8 + fromCol) & Bitboards::squareBit(toRow * 8 + toCol);
 }
 
-bool ChessBoard::isPathClear(int fromRow, int fromCol, int toRow, int toCol) const
+// Клетки, куда фигура может пойти без учёта шаха (для пешки — только ходы и взятия)
+Bitboard ChessBoardData::pieceTargets(int square) const
 {
-    int rowStep = (toRow > fromRow) ? 1 : (toRow < fromRow) ? -1 : 0;
-    int colStep = (toCol > fromCol) ? 1 : (toCol < fromCol) ? -1 : 0;
+    using namespace Bitboards;
+    const ChessPiece &piece = board[square / 8][square % 8];
+    PieceColor color = piece.color();
+    Bitboard occupancy = occupied();
+    Bitboard targets = 0;
+
+    switch (piece.type()) {
+    case PAWN: {
+        int forward = (color == WHITE) ? -8 : 8;
+        int startRow = (color == WHITE) ? 6 : 1;
+        targets = pawnAttacks(color, square) & byColor[color == WHITE ? BLACK : WHITE];
+        if (!(occupancy & squareBit(square + forward))) {
+            targets |= squareBit(square + forward);
+            if (square / 8 == startRow && !(occupancy & squareBit(square + 2 * forward))) {
+                targets |= squareBit(square + 2 * forward);
+            }
+        }
+        return targets;
+    }
+    case KNIGHT: targets = knightAttacks(square); break;
+    case BISHOP: targets = bishopAttacks(square, occupancy); break;
+    case ROOK:   targets = rookAttacks(square, occupancy); break;
+    case QUEEN:  targets = queenAttacks(square, occupancy); break;
+    case KING:   targets = kingAttacks(square); break;
+    default:     return 0;
+    }
+    return targets & ~byColor[color];
+}
 
-    int currentRow = fromRow + rowStep;
-    int currentCol = fromCol + colStep;
+void ChessBoardData::generateMoves(int row, int col, MoveList &moves, bool capturesOnly) const
+{
+    int from = row * 8 + col;
+    Bitboard targets = pieceTargets(from);
+    bool isPawn = board[row][col].type() == PAWN;
+
+    if (capturesOnly) {
+        const Bitboard promotionRanks = 0xFF000000000000FFULL;
+        PieceColor opponent = (board[row][col].color() == WHITE) ? BLACK : WHITE;
+        targets &= byColor[opponent] | (isPawn ? promotionRanks : 0);
+    }
 
-    while (currentRow != toRow || currentCol != toCol) {
-        if (data.board[currentRow][currentCol].type != NO_PIECE) {
-            return false;
+    while (targets) {
+        int to = Bitboards::popLsb(targets);
+        if (isPawn && (to < 8 || to >= 56)) {
+            moves.append(ChessMove(row, col, to / 8, to % 8, QUEEN));
+        } else {
+            moves.append(ChessMove(row, col, to / 8, to % 8));
         }
-        currentRow += rowStep;
-        currentCol += colStep;
     }
-
-    return true;
 }
 
-QVector<QPair<int, int>> ChessBoard::getValidMoves(int row, int col) const
+void ChessBoardData::generateAllMoves(PieceColor color, MoveList &moves, bool capturesOnly) const
 {
-    QVector<QPair<int, int>> moves;
-    for (int toRow = 0; toRow < 8; ++toRow) {
-        for (int toCol = 0; toCol < 8; ++toCol) {
-            if (isValidMove(row, col, toRow, toCol)) {
-                moves.append(qMakePair(toRow, toCol));
-            }
-        }
+    Bitboard own = byColor[color];
+    while (own) {
+        int square = Bitboards::popLsb(own);
+        generateMoves(square / 8, square % 8, moves, capturesOnly);
     }
-    return moves;
 }
 
-bool ChessBoard::isInCheck(PieceColor color) const
+void ChessBoardData::generateLegalMoves(PieceColor color, MoveList &moves, bool capturesOnly) const
 {
-    // Находим короля
-    int kingRow = -1, kingCol = -1;
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            if (data.board[row][col].type == KING && data.board[row][col].color == color) {
-                kingRow = row;
-                kingCol = col;
-                break;
-            }
+    using namespace Bitboards;
+
+    int first = moves.size();
+    generateAllMoves(color, moves, capturesOnly);
+
+    int king = kingSquare(color);
+    if (king < 0) {
+        return; // Короля уже нет — отсеивать нечего
+    }
+
+    PieceColor opponent = (color == WHITE) ? BLACK : WHITE;
+    Bitboard occupancy = occupied();
+    Bitboard checkers = attackersTo(king, occupancy) & byColor[opponent];
+
+    // Связанные фигуры: единственная своя фигура между королём и дальнобойной фигурой противника
+    Bitboard pinned = 0;
+    Bitboard snipers = ((rookAttacks(king, 0) & (byType[ROOK] | byType[QUEEN])) |
+                        (bishopAttacks(king, 0) & (byType[BISHOP] | byType[QUEEN]))) & byColor[opponent];
+    while (snipers) {
+        Bitboard blockers = between(king, popLsb(snipers)) & occupancy;
+        if (blockers && !moreThanOne(blockers)) {
+            pinned |= blockers & byColor[color];
         }
     }
 
-    if (kingRow == -1) return true; // Король съеден
+    // При шахе ход должен взять шахующую фигуру или закрыться от неё
+    Bitboard evasionTargets = ~Bitboard(0);
+    if (checkers) {
+        evasionTargets = moreThanOne(checkers) ? 0 : checkers | between(king, lsb(checkers));
+    }
 
-    // Проверяем, может ли любая фигура противника атаковать короля
-    PieceColor opponentColor = (color == WHITE) ? BLACK : WHITE;
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            if (data.board[row][col].color == opponentColor) {
-                // Используем текущую доску для проверки
-                if (isValidMove(row, col, kingRow, kingCol)) {
-                    return true;
-                }
-            }
+    int kept = first;
+    for (int i = first; i < moves.size(); ++i) {
+        const ChessMove &move = moves[i];
+        int from = move.from();
+        int to = move.to();
+        bool legal;
+        if (from == king) {
+            legal = !(attackersTo(to, occupancy ^ squareBit(from)) & byColor[opponent]);
+        } else {
+            legal = (evasionTargets & squareBit(to)) &&
+                    (!(pinned & squareBit(from)) || (line(king, from) & squareBit(to)));
+        }
+        if (legal) {
+            moves[kept++] = move;
         }
     }
+    moves.count = kept;
+}
 
-    return false;
+bool ChessBoardData::isInCheck(PieceColor color) const
+{
+    int king = kingSquare(color);
+    if (king < 0) return true; // Король съеден
+
+    PieceColor opponentColor = (color == WHITE) ? BLACK : WHITE;
+    return attackersTo(king, occupied()) & byColor[opponentColor];
 }
 
-bool ChessBoard::isCheckmate(PieceColor color) const
+bool ChessBoardData::isCheckmate(PieceColor color) const
 {
     if (!isInCheck(color)) {
         return false;
     }
 
     // Проверяем, есть ли хоть один ход, который убирает шах
-    for (int fromRow = 0; fromRow < 8; ++fromRow) {
-        for (int fromCol = 0; fromCol < 8; ++fromCol) {
-            if (data.board[fromRow][fromCol].color == color) {
-                QVector<QPair<int, int>> moves = getValidMoves(fromRow, fromCol);
-                for (const auto &move : moves) {
-                    // Создаем временную копию доски
-                    ChessBoardData tempData = data;
-                    ChessBoard tempBoard;
-                    tempBoard.setBoardData(tempData);
-
-                    tempBoard.makeMoveForAI(fromRow, fromCol, move.first, move.second);
-                    if (!tempBoard.isInCheck(color)) {
-                        return false;
-                    }
-                }
-            }
-        }
-    }
-
-    return true;
+    MoveList moves;
+    generateLegalMoves(color, moves);
+    return moves.isEmpty();
 }
 
-bool ChessBoard::isStalemate(PieceColor color) const
+bool ChessBoardData::isStalemate(PieceColor color) const
 {
     if (isInCheck(color)) {
         return false;
     }
 
     // Проверяем, есть ли хоть один допустимый ход
-    for (int fromRow = 0; fromRow < 8; ++fromRow) {
-        for (int fromCol = 0; fromCol < 8; ++fromCol) {
-            if (data.board[fromRow][fromCol].color == color) {
-                QVector<QPair<int, int>> moves = getValidMoves(fromRow, fromCol);
-                if (!moves.isEmpty()) {
-                    return false;
-                }
-            }
-        }
+    MoveList moves;
+    generateLegalMoves(color, moves);
+    return moves.isEmpty();
+}
+
+void ChessBoardData::makeMove(int fromRow, int fromCol, int toRow, int toCol)
+{
+    // Превращение пешки
+    if (board[fromRow][fromCol].type() == PAWN && (toRow == 0 || toRow == 7)) {
+        makeMove(ChessMove(fromRow, fromCol, toRow, toCol, QUEEN));
+    } else {
+        makeMove(ChessMove(fromRow, fromCol, toRow, toCol));
     }
+}
 
-    return true;
+void ChessBoardData::makeMove(const ChessMove &move)
+{
+    int from = move.from();
+    int to = move.to();
+    ChessPiece piece = board[from / 8][from % 8];
+
+    // Взятие и ход пешкой необратимы: повторение до них невозможно
+    if (piece.type() == PAWN || !board[to / 8][to % 8].isEmpty()) {
+        halfmoveClock = 0;
+    } else {
+        ++halfmoveClock;
+    }
+
+    removePiece(to);
+    removePiece(from);
+
+    // Превращение пешки
+    if (move.flag() == PROMOTION_MOVE) {
+        piece = ChessPiece(move.promotion(), piece.color());
+    }
+    putPiece(to, piece);
+
+    key ^= ZOBRIST.castling[castlingRights];
+    castlingRights &= castlingRightsKept(from) & castlingRightsKept(to);
+    key ^= ZOBRIST.castling[castlingRights];
+    switchPlayer();
+}
+
+void ChessBoardData::makeMove(const ChessMove &move, MoveUndo &undo)
+{
+    undo.moved = board[move.fromRow()][move.fromCol()];
+    undo.captured = board[move.toRow()][move.toCol()];
+    undo.key = key;
+    undo.castlingRights = castlingRights;
+    undo.halfmoveClock = halfmoveClock;
+    undo.gameState = gameState;
+    makeMove(move);
+}
+
+void ChessBoardData::unmakeMove(const ChessMove &move, const MoveUndo &undo)
+{
+    removePiece(move.to());
+    putPiece(move.from(), undo.moved);
+    if (!undo.captured.isEmpty()) {
+        putPiece(move.to(), undo.captured);
+    }
+    castlingRights = undo.castlingRights;
+    halfmoveClock = undo.halfmoveClock;
+    gameState = undo.gameState;
+    switchPlayer();
+    key = undo.key;
+}
+
+void ChessBoardData::makeNullMove(MoveUndo &undo)
+{
+    undo.key = key;
+    undo.halfmoveClock = halfmoveClock;
+    // Через нулевой ход повторение не ищем
+    halfmoveClock = 0;
+    switchPlayer();
+}
+
+void ChessBoardData::unmakeNullMove(const MoveUndo &undo)
+{
+    switchPlayer();
+    halfmoveClock = undo.halfmoveClock;
+    key = undo.key;
+}
+
+bool ChessBoardData::hasNonPawnMaterial(PieceColor color) const
+{
+    return byColor[color] & (byType[KNIGHT] | byType[BISHOP] | byType[ROOK] | byType[QUEEN]);
+}
+
+bool ChessBoardData::isRepetition(const quint64 *keys, int count, int times) const
+{
+    // Та же позиция — с той же очередью хода (через чётное число полуходов)
+    // и не раньше последнего необратимого хода
+    int first = qMax(0, count - halfmoveClock);
+    int found = 0;
+    for (int i = count - 2; i >= first; i -= 2) {
+        if (keys[i] == key && ++found >= times) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void ChessBoard::switchPlayer()
+void ChessBoardData::switchPlayer()
 {
-    data.currentPlayer = (data.currentPlayer == WHITE) ? BLACK : WHITE;
+    currentPlayer = (currentPlayer == WHITE) ? BLACK : WHITE;
+    key ^= ZOBRIST.side;
 }
 
-void ChessBoard::updateGameState()
+void ChessBoardData::updateGameState()
 {
     if (isCheckmate(WHITE)) {
-        data.gameState = BLACK_WIN;
+        gameState = BLACK_WIN;
     } else if (isCheckmate(BLACK)) {
-        data.gameState = WHITE_WIN;
-    } else if (isStalemate(data.currentPlayer)) {
-        data.gameState = STALEMATE;
+        gameState = WHITE_WIN;
+    } else if (isStalemate(currentPlayer)) {
+        gameState = STALEMATE;
+    } else if (halfmoveClock >= 100) {
+        gameState = DRAW; // правило 50 ходов
     } else {
-        data.gameState = IN_PROGRESS;
+        gameState = IN_PROGRESS;
+    }
+}
+
+// Реализация ChessBoard
+namespace {
+
+const int SQUARE_SIZE = 65;
+const int BOARD_SIZE = SQUARE_SIZE * 8;
+
+}
+
+ChessBoard::ChessBoard(QObject *parent)
+    : QObject(parent), drawReason(NO_DRAW), selectedRow(-1), selectedCol(-1), pieceSelected(false),
+      cacheScale(0)
+{
+    setFlag(QGraphicsItem::ItemIsFocusable);
+    // Нужен option->exposedRect, чтобы перерисовывать только изменённые клетки
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    resetBoard();
+}
+
+ChessBoard::~ChessBoard()
+{
+}
+
+QRectF ChessBoard::boundingRect() const
+{
+    return QRectF(0, 0, BOARD_SIZE, BOARD_SIZE);
+}
+
+QRectF ChessBoard::squareRect(int row, int col) const
+{
+    return QRectF(col * SQUARE_SIZE, row * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE);
+}
+
+void ChessBoard::updateSquare(int row, int col)
+{
+    update(squareRect(row, col));
+}
+
+void ChessBoard::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    // Размер клетки в пикселях устройства: devicePixelRatio экрана и масштаб вида
+    qreal scale = painter->device()->devicePixelRatioF() *
+                  QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (!qFuzzyCompare(scale, cacheScale)) {
+        updateRenderCache(scale);
+    }
+
+    // Рисуем только клетки, попавшие в обновляемую область
+    QRectF exposed = option->exposedRect.intersected(boundingRect());
+    if (exposed.isEmpty()) {
+        return;
+    }
+    painter->drawPixmap(exposed, backgroundCache,
+                        QRectF(exposed.x() * scale, exposed.y() * scale,
+                               exposed.width() * scale, exposed.height() * scale));
+
+    int firstRow = qBound(0, int(exposed.top() / SQUARE_SIZE), 7);
+    int lastRow = qBound(0, int(exposed.bottom() / SQUARE_SIZE), 7);
+    int firstCol = qBound(0, int(exposed.left() / SQUARE_SIZE), 7);
+    int lastCol = qBound(0, int(exposed.right() / SQUARE_SIZE), 7);
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            QRectF rect = squareRect(row, col);
+
+            // Подсвечиваем выбранную клетку
+            if (pieceSelected && selectedRow == row && selectedCol == col) {
+                painter->fillRect(rect, QColor(255, 255, 0, 100));
+            }
+
+            // Рисуем фигуру
+            const ChessPiece &piece = data.board[row][col];
+            if (!piece.isEmpty()) {
+                painter->drawPixmap(rect.topLeft(), pieceCache[piece.color()][piece.type()]);
+            }
+        }
+    }
+}
+
+void ChessBoard::updateRenderCache(qreal scale)
+{
+    cacheScale = scale;
+
+    backgroundCache = QPixmap(qCeil(BOARD_SIZE * scale), qCeil(BOARD_SIZE * scale));
+    backgroundCache.setDevicePixelRatio(scale);
+    QPainter painter(&backgroundCache);
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            // Чередуем цвета клеток
+            if ((row + col) % 2 == 0) {
+                painter.fillRect(squareRect(row, col), QColor(240, 217, 181)); // Светлая клетка
+            } else {
+                painter.fillRect(squareRect(row, col), QColor(181, 136, 99)); // Темная клетка
+            }
+        }
+    }
+    painter.end();
+
+    for (int type = PAWN; type <= KING; ++type) {
+        pieceCache[WHITE][type] = renderPiece(PieceType(type), WHITE, scale);
+        pieceCache[BLACK][type] = renderPiece(PieceType(type), BLACK, scale);
+    }
+}
+
+QPixmap ChessBoard::renderPiece(PieceType type, PieceColor color, qreal scale) const
+{
+    QString pieceChar;
+    QColor pieceColor = (color == WHITE) ? Qt::white : Qt::black;
+
+    switch (type) {
+    case PAWN:   pieceChar = "♙"; break;
+    case KNIGHT: pieceChar = "♘"; break;
+    case BISHOP: pieceChar = "♗"; break;
+    case ROOK:   pieceChar = "♖"; break;
+    case QUEEN:  pieceChar = "♕"; break;
+    case KING:   pieceChar = "♔"; break;
+    default:     return QPixmap();
+    }
+
+    QPixmap pixmap(qCeil(SQUARE_SIZE * scale), qCeil(SQUARE_SIZE * scale));
+    pixmap.setDevicePixelRatio(scale);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.setFont(QFont("Arial", 40));
+    painter.setPen(pieceColor);
+    painter.drawText(QRectF(0, 0, SQUARE_SIZE, SQUARE_SIZE), Qt::AlignCenter, pieceChar);
+    return pixmap;
+}
+
+void ChessBoard::resetBoard()
+{
+    data.reset();
+    positionHistory.clear();
+    drawReason = NO_DRAW;
+    pieceSelected = false;
+    update();
+    emit gameStateChanged();
+}
+
+void ChessBoard::setBoardData(const ChessBoardData &newData)
+{
+    // История новой позиции неизвестна
+    data.copyFrom(newData);
+    positionHistory.clear();
+    drawReason = NO_DRAW;
+    update();
+    emit gameStateChanged();
+}
+
+bool ChessBoard::makeMove(int fromRow, int fromCol, int toRow, int toCol)
+{
+    // После мата, пата или ничьей партия закончена
+    if (data.gameState != IN_PROGRESS || !isValidMove(fromRow, fromCol, toRow, toCol)) {
+        return false;
+    }
+
+    applyMove(fromRow, fromCol, toRow, toCol);
+    return true;
+}
+
+void ChessBoard::applyMove(int fromRow, int fromCol, int toRow, int toCol)
+{
+    // Выполняем ход; перерисовываются только две затронутые клетки
+    positionHistory.append(data.key);
+    data.makeMove(fromRow, fromCol, toRow, toCol);
+    data.updateGameState();
+
+    drawReason = NO_DRAW;
+    if (data.gameState == DRAW) {
+        drawReason = DRAW_BY_FIFTY_MOVES;
+    } else if (data.gameState == IN_PROGRESS && data.isRepetition(positionHistory, 2)) {
+        // Троекратное повторение: текущая позиция и ещё две такие же в истории
+        data.gameState = DRAW;
+        drawReason = DRAW_BY_REPETITION;
     }
+
+    updateSquare(fromRow, fromCol);
+    updateSquare(toRow, toCol);
+    emit gameStateChanged();
+}
+
+bool ChessBoard::isValidMove(int fromRow, int fromCol, int toRow, int toCol) const
+{
+    return data.isValidMove(fromRow, fromCol, toRow, toCol);
+}
+
+QVector<QPair<int, int>> ChessBoard::getValidMoves(int row, int col) const
+{
+    QVector<QPair<int, int>> moves;
+    if (row < 0 || row > 7 || col < 0 || col > 7 || data.board[row][col].color() != data.currentPlayer) {
+        return moves;
+    }
+
+    MoveList list;
+    data.generateMoves(row, col, list);
+    for (const ChessMove &move : list) {
+        moves.append(qMakePair(move.toRow(), move.toCol()));
+    }
+    return moves;
+}
+
+bool ChessBoard::isInCheck(PieceColor color) const
+{
+    return data.isInCheck(color);
+}
+
+bool ChessBoard::isCheckmate(PieceColor color) const
+{
+    return data.isCheckmate(color);
+}
+
+bool ChessBoard::isStalemate(PieceColor color) const
+{
+    return data.isStalemate(color);
 }
 
 void ChessBoard::mousePressEvent(QGraphicsSceneMouseEvent *event)
@@ -420,8 +973,8 @@ void ChessBoard::mousePressEvent(QGraphicsSceneMouseEvent *event)
         return;
     }
 
-    int col = event->pos().x() / 65;
-    int row = event->pos().y() / 65;
+    int col = event->pos().x() / SQUARE_SIZE;
+    int row = event->pos().y() / SQUARE_SIZE;
 
     if (row < 0 || row > 7 || col < 0 || col > 7) {
         return;
@@ -429,26 +982,29 @@ void ChessBoard::mousePressEvent(QGraphicsSceneMouseEvent *event)
 
     if (!pieceSelected) {
         // Выбираем фигуру
-        if (data.board[row][col].type != NO_PIECE && data.board[row][col].color == data.currentPlayer) {
+        if (data.board[row][col].type() != NO_PIECE && data.board[row][col].color() == data.currentPlayer) {
             selectedRow = row;
             selectedCol = col;
             pieceSelected = true;
-            update();
+            updateSquare(row, col);
         }
     } else {
+        // Старая подсветка снимается, новая клетка перерисуется ниже
+        updateSquare(selectedRow, selectedCol);
+
         // Пытаемся сделать ход
         if (makeMove(selectedRow, selectedCol, row, col)) {
             pieceSelected = false;
         } else {
             // Если ход не удался, снимаем выделение или выбираем другую фигуру
-            if (data.board[row][col].type != NO_PIECE && data.board[row][col].color == data.currentPlayer) {
+            if (data.board[row][col].type() != NO_PIECE && data.board[row][col].color() == data.currentPlayer) {
                 selectedRow = row;
                 selectedCol = col;
             } else {
                 pieceSelected = false;
             }
         }
-        update();
+        updateSquare(row, col);
     }
 }
 
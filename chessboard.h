@@ -1,8 +1,10 @@
 #ifndef CHESSBOARD_H
 #define CHESSBOARD_H
 
+#include "bitboard.h"
 #include <QGraphicsItem>
 #include <QObject>
+#include <QPixmap>
 #include <QVector>
 
 enum PieceType {
@@ -29,25 +31,171 @@ enum GameState {
     DRAW
 };
 
+enum DrawReason {
+    NO_DRAW,
+    DRAW_BY_REPETITION,
+    DRAW_BY_FIFTY_MOVES
+};
+
+// Фигура кодируется одним байтом: биты 0-2 — тип, биты 3-4 — цвет
 struct ChessPiece {
-    PieceType type;
-    PieceColor color;
-    bool hasMoved;
+    quint8 code;
+
+    ChessPiece() : code(NO_COLOR << 3) {}
+    ChessPiece(PieceType t, PieceColor c) : code(quint8(t | (c << 3))) {}
+
+    PieceType type() const { return PieceType(code & 7); }
+    PieceColor color() const { return PieceColor(code >> 3); }
+    bool isEmpty() const { return (code & 7) == NO_PIECE; }
+};
+
+enum MoveFlag {
+    NORMAL_MOVE,
+    PROMOTION_MOVE
+};
+
+// Ход упакован в 16 бит: биты 0-5 — откуда, 6-11 — куда,
+// 12-13 — фигура превращения (конь..ферзь), 14-15 — флаг хода.
+// Клетка нумеруется как row * 8 + col, нулевой ход a8-a8 служит пустым значением
+struct ChessMove {
+    quint16 data;
+
+    ChessMove() : data(0) {}
+    ChessMove(int fr, int fc, int tr, int tc)
+        : data(quint16((fr * 8 + fc) | ((tr * 8 + tc) << 6))) {}
+    ChessMove(int fr, int fc, int tr, int tc, PieceType promotion)
+        : data(quint16((fr * 8 + fc) | ((tr * 8 + tc) << 6) |
+                       ((promotion - KNIGHT) << 12) | (PROMOTION_MOVE << 14))) {}
+
+    int from() const { return data & 63; }
+    int to() const { return (data >> 6) & 63; }
+    int fromRow() const { return from() >> 3; }
+    int fromCol() const { return from() & 7; }
+    int toRow() const { return to() >> 3; }
+    int toCol() const { return to() & 7; }
+    MoveFlag flag() const { return MoveFlag(data >> 14); }
+    PieceType promotion() const {
+        return flag() == PROMOTION_MOVE ? PieceType(KNIGHT + ((data >> 12) & 3)) : NO_PIECE;
+    }
+
+    bool isNull() const { return data == 0; }
+    QString toString() const; // координатная запись, например e2e4 или a7a8q
+    bool operator==(const ChessMove &other) const { return data == other.data; }
+    bool operator!=(const ChessMove &other) const { return data != other.data; }
+};
 
-    ChessPiece() : type(NO_PIECE), color(NO_COLOR), hasMoved(false) {}
-    ChessPiece(PieceType t, PieceColor c) : type(t), color(c), hasMoved(false) {}
+// Права на рокировку хранятся флагами позиции, а не признаком «ходила» у каждой фигуры
+enum CastlingRight {
+    WHITE_KINGSIDE = 1,
+    WHITE_QUEENSIDE = 2,
+    BLACK_KINGSIDE = 4,
+    BLACK_QUEENSIDE = 8,
+    ALL_CASTLING = 15
 };
 
-// Класс только для данных, без QObject
+// В шахматах не бывает больше 218 ходов из одной позиции
+const int MAX_MOVES = 256;
+
+// Список ходов фиксированной ёмкости: живёт на стеке или в арене поиска,
+// поэтому генерация ходов не обращается к куче
+struct MoveList {
+    ChessMove moves[MAX_MOVES];
+    int count;
+
+    MoveList() : count(0) {}
+    void clear() { count = 0; }
+    void append(const ChessMove &move) { moves[count++] = move; }
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    ChessMove &operator[](int i) { return moves[i]; }
+    const ChessMove &operator[](int i) const { return moves[i]; }
+    ChessMove *begin() { return moves; }
+    ChessMove *end() { return moves + count; }
+    const ChessMove *begin() const { return moves; }
+    const ChessMove *end() const { return moves + count; }
+};
+
+// Всё, что нужно для отмены хода без копирования доски
+struct MoveUndo {
+    quint64 key;
+    ChessPiece moved;
+    ChessPiece captured;
+    quint8 castlingRights;
+    int halfmoveClock;
+    GameState gameState;
+};
+
+// Класс только для данных, без QObject.
+// Доска хранится дважды: массивом board для быстрого доступа к клетке
+// и битбордами для генерации ходов и поиска атак
 class ChessBoardData {
 public:
     ChessPiece board[8][8];
     PieceColor currentPlayer;
     GameState gameState;
+    quint8 castlingRights;
+    int halfmoveClock;  // полуходы с последнего взятия или хода пешкой
+    quint64 key;        // ключ Zobrist: фигуры, очередь хода, права на рокировку
+    Bitboard byColor[2];
+    Bitboard byType[7];
 
     ChessBoardData();
     void reset();
+    // Позиция из FEN; взятие на проходе не поддерживается и пропускается
+    bool loadFen(const QString &fen);
+    // Номер хода не хранится, в FEN всегда пишется 1
+    QString toFen() const;
     void copyFrom(const ChessBoardData &other);
+    // Пересчитывает битборды и ключ по массиву board
+    void refreshBitboards();
+
+    Bitboard occupied() const { return byColor[WHITE] | byColor[BLACK]; }
+    Bitboard pieces(PieceColor color, PieceType type) const { return byColor[color] & byType[type]; }
+    Bitboard attackersTo(int square, Bitboard occupancy) const;
+    int kingSquare(PieceColor color) const;
+    // Размен на клетке хода (SEE): материальный итог серии взятий для ходящей стороны
+    int staticExchange(const ChessMove &move) const;
+
+    // Правила ходов. isPseudoLegal не проверяет очередь хода и шах своему королю
+    bool isPseudoLegal(int fromRow, int fromCol, int toRow, int toCol) const;
+    bool isValidMove(int fromRow, int fromCol, int toRow, int toCol) const;
+    // capturesOnly оставляет только взятия и превращения (для форсированного поиска)
+    void generateMoves(int row, int col, MoveList &moves, bool capturesOnly = false) const;
+    void generateAllMoves(PieceColor color, MoveList &moves, bool capturesOnly = false) const;
+    void generateLegalMoves(PieceColor color, MoveList &moves, bool capturesOnly = false) const;
+    bool isInCheck(PieceColor color) const;
+    bool isCheckmate(PieceColor color) const;
+    bool isStalemate(PieceColor color) const;
+    bool hasNonPawnMaterial(PieceColor color) const;
+    // Встречалась ли текущая позиция times раз среди предыдущих позиций партии
+    // keys[0..count), где keys[count - 1] — позиция за полуход до текущей
+    bool isRepetition(const quint64 *keys, int count, int times) const;
+    bool isRepetition(const QVector<quint64> &history, int times) const
+    {
+        return isRepetition(history.constData(), history.size(), times);
+    }
+
+    // Ход без проверок; состояние игры не пересчитывается
+    void makeMove(int fromRow, int fromCol, int toRow, int toCol);
+    void makeMove(const ChessMove &move);
+    void makeMove(const ChessMove &move, MoveUndo &undo);
+    void unmakeMove(const ChessMove &move, const MoveUndo &undo);
+    // Пропуск хода для нулевого хода в поиске
+    void makeNullMove(MoveUndo &undo);
+    void unmakeNullMove(const MoveUndo &undo);
+    void switchPlayer();
+    void updateGameState();
+
+private:
+    void putPiece(int square, ChessPiece piece);
+    void removePiece(int square);
+    Bitboard pieceTargets(int square) const;
+    bool isValidPawnMove(int fromRow, int fromCol, int toRow, int toCol) const;
+    bool isValidKnightMove(int fromRow, int fromCol, int toRow, int toCol) const;
+    bool isValidBishopMove(int fromRow, int fromCol, int toRow, int toCol) const;
+    bool isValidRookMove(int fromRow, int fromCol, int toRow, int toCol) const;
+    bool isValidQueenMove(int fromRow, int fromCol, int toRow, int toCol) const;
+    bool isValidKingMove(int fromRow, int fromCol, int toRow, int toCol) const;
 };
 
 class ChessBoard : public QObject, public QGraphicsItem
@@ -72,12 +220,14 @@ public:
 
     PieceColor getCurrentPlayer() const { return data.currentPlayer; }
     GameState getGameState() const { return data.gameState; }
+    DrawReason getDrawReason() const { return drawReason; }
+    // Ключи позиций, предшествовавших текущей, в порядке партии
+    const QVector<quint64> &getPositionHistory() const { return positionHistory; }
     ChessPiece getPiece(int row, int col) const { return data.board[row][col]; }
 
     // Для ИИ
     ChessBoardData getBoardData() const { return data; }
     void setBoardData(const ChessBoardData &newData);
-    void makeMoveForAI(int fromRow, int fromCol, int toRow, int toCol);
 
 signals:
     void gameStateChanged();
@@ -88,19 +238,22 @@ protected:
 
 private:
     ChessBoardData data;
+    QVector<quint64> positionHistory;
+    DrawReason drawReason;
     int selectedRow, selectedCol;
     bool pieceSelected;
 
-    void drawPiece(QPainter *painter, PieceType type, PieceColor color, const QRectF &rect);
-    bool isValidPawnMove(int fromRow, int fromCol, int toRow, int toCol) const;
-    bool isValidKnightMove(int fromRow, int fromCol, int toRow, int toCol) const;
-    bool isValidBishopMove(int fromRow, int fromCol, int toRow, int toCol) const;
-    bool isValidRookMove(int fromRow, int fromCol, int toRow, int toCol) const;
-    bool isValidQueenMove(int fromRow, int fromCol, int toRow, int toCol) const;
-    bool isValidKingMove(int fromRow, int fromCol, int toRow, int toCol) const;
-    bool isPathClear(int fromRow, int fromCol, int toRow, int toCol) const;
-    void switchPlayer();
-    void updateGameState();
+    // Кэш отрисовки: фон доски и 12 изображений фигур.
+    // Пересоздаётся только при смене масштаба вида или devicePixelRatio
+    QPixmap backgroundCache;
+    QPixmap pieceCache[2][7];
+    qreal cacheScale;
+
+    void updateRenderCache(qreal scale);
+    QPixmap renderPiece(PieceType type, PieceColor color, qreal scale) const;
+    QRectF squareRect(int row, int col) const;
+    void updateSquare(int row, int col);
+    void applyMove(int fromRow, int fromCol, int toRow, int toCol);
 };
 
 #endif // CHESSBOARD_H
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include <QCoreApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -28,23 +29,36 @@ MainWindow::MainWindow(QWidget *parent)
     // Создаем ИИ
     chessAI = new ChessAI(chessBoard);
 
+    // Если рядом с программой лежат веса сети, ИИ оценивает позиции ею
+    network.reset(new NnueNetwork);
+    if (network->load(QCoreApplication::applicationDirPath() + "/chess.nnue")) {
+        chessAI->setNetwork(network.data());
+    }
+
     // Панель управления
     QHBoxLayout *controlLayout = new QHBoxLayout();
 
     newGameButton = new QPushButton("Новая игра");
     aiMoveButton = new QPushButton("Ход ИИ");
+    hintButton = new QPushButton("Подсказка");
     statusLabel = new QLabel("Ход белых");
 
     controlLayout->addWidget(newGameButton);
     controlLayout->addWidget(aiMoveButton);
+    controlLayout->addWidget(hintButton);
     controlLayout->addWidget(statusLabel);
     controlLayout->addStretch();
 
     mainLayout->addLayout(controlLayout);
 
+    // Оценка и ожидаемое продолжение после хода ИИ
+    analysisLabel = new QLabel();
+    mainLayout->addWidget(analysisLabel);
+
     // Подключаем сигналы
     connect(newGameButton, &QPushButton::clicked, this, &MainWindow::newGame);
     connect(aiMoveButton, &QPushButton::clicked, this, &MainWindow::aiMove);
+    connect(hintButton, &QPushButton::clicked, this, &MainWindow::showHint);
     connect(chessBoard, &ChessBoard::gameStateChanged, this, &MainWindow::updateStatus);
 
     newGame();
@@ -57,15 +71,50 @@ MainWindow::~MainWindow()
 void MainWindow::newGame()
 {
     chessBoard->resetBoard();
+    analysisLabel->clear();
     updateStatus();
 }
 
 void MainWindow::aiMove()
 {
+    if (chessBoard->getGameState() != IN_PROGRESS) {
+        return;
+    }
+
     if (chessBoard->getCurrentPlayer() == BLACK) {
-        ChessMove move = chessAI->findBestMove(3); // Глубина поиска 3
-        chessBoard->makeMove(move.fromRow, move.fromCol, move.toRow, move.toCol);
+        SearchResult result = chessAI->findBestMove(3); // Глубина поиска 3
+        if (result.bestMove.isNull()) {
+            return;
+        }
+
+        QStringList line;
+        for (const ChessMove &move : result.pv) {
+            line << move.toString();
+        }
+        // Оценка в пешках с точки зрения черных
+        analysisLabel->setText(QString("Оценка: %1  Вариант: %2")
+                               .arg(result.score / 100.0, 0, 'f', 2)
+                               .arg(line.join(' ')));
+
+        const ChessMove &move = result.bestMove;
+        chessBoard->makeMove(move.fromRow(), move.fromCol(), move.toRow(), move.toCol());
+    }
+}
+
+void MainWindow::showHint()
+{
+    if (chessBoard->getGameState() != IN_PROGRESS) {
+        return;
+    }
+
+    // Три лучших хода для стороны, которая ходит, с оценкой в пешках с её точки зрения
+    QVector<SearchResult> lines = chessAI->findBestMoves(4, 3);
+    QStringList hints;
+    for (const SearchResult &line : lines) {
+        hints << QString("%1 (%2)").arg(line.bestMove.toString())
+                                   .arg(line.score / 100.0, 0, 'f', 2);
     }
+    analysisLabel->setText(QString("Подсказка: %1").arg(hints.join(", ")));
 }
 
 void MainWindow::updateStatus()
@@ -85,7 +134,16 @@ void MainWindow::updateStatus()
         status = "Пат!";
         break;
     case DRAW:
-        status = "Ничья!";
+        switch (chessBoard->getDrawReason()) {
+        case DRAW_BY_REPETITION:
+            status = "Ничья: троекратное повторение позиции";
+            break;
+        case DRAW_BY_FIFTY_MOVES:
+            status = "Ничья: правило 50 ходов";
+            break;
+        default:
+            status = "Ничья!";
+        }
         break;
     }
     statusLabel->setText(status);
@@ -6,8 +6,10 @@
 #include <QGraphicsView>
 #include <QPushButton>
 #include <QLabel>
+#include <QScopedPointer>
 #include "chessboard.h"
 #include "chessai.h"
+#include "nnue.h"
 
 class MainWindow : public QMainWindow
 {
@@ -20,6 +22,7 @@ public:
 private slots:
     void newGame();
     void aiMove();
+    void showHint();
     void updateStatus();
 
 private:
@@ -27,9 +30,12 @@ private:
     QGraphicsView *view;
     ChessBoard *chessBoard;
     ChessAI *chessAI;
+    QScopedPointer<NnueNetwork> network;
     QPushButton *newGameButton;
     QPushButton *aiMoveButton;
+    QPushButton *hintButton;
     QLabel *statusLabel;
+    QLabel *analysisLabel;
 };
 
 #endif // MAINWINDOW_H
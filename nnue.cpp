@@ -0,0 +1,191 @@
+#include "nnue.h"
+#include <QDataStream>
+#include <QFile>
+#include <cstring>
+
+// Векторные версии выбираются при сборке: AVX2 (-mavx2 или -march=native),
+// иначе SSE2, который есть на любом x86-64, иначе обычные циклы.
+// Загрузки невыровненные: на выровненных данных они не медленнее,
+// а аккумулятор, скопированный в чужой буфер, не уронят
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NNUE_SSE2
+#endif
+
+namespace {
+
+void addRow(qint16 *values, const qint16 *row)
+{
+#if defined(NNUE_AVX2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i *target = reinterpret_cast<__m256i *>(values + i);
+        __m256i weights = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        _mm256_storeu_si256(target, _mm256_add_epi16(_mm256_loadu_si256(target), weights));
+    }
+#elif defined(NNUE_SSE2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i *target = reinterpret_cast<__m128i *>(values + i);
+        __m128i weights = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        _mm_storeu_si128(target, _mm_add_epi16(_mm_loadu_si128(target), weights));
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        values[i] += row[i];
+    }
+#endif
+}
+
+void subRow(qint16 *values, const qint16 *row)
+{
+#if defined(NNUE_AVX2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i *target = reinterpret_cast<__m256i *>(values + i);
+        __m256i weights = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        _mm256_storeu_si256(target, _mm256_sub_epi16(_mm256_loadu_si256(target), weights));
+    }
+#elif defined(NNUE_SSE2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i *target = reinterpret_cast<__m128i *>(values + i);
+        __m128i weights = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        _mm_storeu_si128(target, _mm_sub_epi16(_mm_loadu_si128(target), weights));
+    }
+#else
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        values[i] -= row[i];
+    }
+#endif
+}
+
+// Скалярное произведение clamp(values, 0, QA) на веса выходного слоя
+qint32 clippedDot(const qint16 *values, const qint16 *weights)
+{
+#if defined(NNUE_AVX2)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i limit = _mm256_set1_epi16(NNUE_QA);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+        v = _mm256_min_epi16(_mm256_max_epi16(v, zero), limit);
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, w));
+    }
+    __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(1, 0, 3, 2)));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(total);
+#elif defined(NNUE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi16(NNUE_QA);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        v = _mm_min_epi16(_mm_max_epi16(v, zero), limit);
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(v, w));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+#else
+    qint32 sum = 0;
+    for (int i = 0; i < NNUE_HIDDEN; ++i) {
+        sum += qBound<qint32>(0, values[i], NNUE_QA) * weights[i];
+    }
+    return sum;
+#endif
+}
+
+}
+
+NnueNetwork::NnueNetwork()
+    : outputBias(0), loaded(false)
+{
+}
+
+bool NnueNetwork::load(const QString &fileName)
+{
+    loaded = false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    char magic[4];
+    quint32 version = 0;
+    quint32 hidden = 0;
+    if (in.readRawData(magic, 4) != 4 || std::memcmp(magic, "NNUE", 4) != 0) {
+        return false;
+    }
+    in >> version >> hidden;
+    if (version != NNUE_FILE_VERSION || hidden != quint32(NNUE_HIDDEN)) {
+        return false;
+    }
+
+    for (int i = 0; i < NNUE_INPUTS; ++i) {
+        for (int j = 0; j < NNUE_HIDDEN; ++j) {
+            in >> featureWeights[i][j];
+        }
+    }
+    for (int j = 0; j < NNUE_HIDDEN; ++j) {
+        in >> featureBias[j];
+    }
+    for (int j = 0; j < 2 * NNUE_HIDDEN; ++j) {
+        in >> outputWeights[j];
+    }
+    in >> outputBias;
+
+    loaded = in.status() == QDataStream::Ok;
+    return loaded;
+}
+
+void NnueNetwork::refresh(const ChessBoardData &position, NnueAccumulator &accumulator) const
+{
+    for (int perspective = WHITE; perspective <= BLACK; ++perspective) {
+        qint16 *values = accumulator.values[perspective];
+        std::memcpy(values, featureBias, sizeof(featureBias));
+
+        Bitboard occupied = position.occupied();
+        while (occupied) {
+            int square = Bitboards::popLsb(occupied);
+            const ChessPiece &piece = position.board[square / 8][square % 8];
+            addRow(values, featureWeights[nnueFeature(PieceColor(perspective), piece, square)]);
+        }
+    }
+}
+
+void NnueNetwork::update(const NnueAccumulator &parent, NnueAccumulator &child,
+                         const ChessBoardData &position, const ChessMove &move) const
+{
+    int from = move.from();
+    int to = move.to();
+    const ChessPiece &moved = position.board[from / 8][from % 8];
+    const ChessPiece &captured = position.board[to / 8][to % 8];
+    ChessPiece placed = move.flag() == PROMOTION_MOVE ? ChessPiece(move.promotion(), moved.color())
+                                                      : moved;
+
+    child = parent;
+    for (int perspective = WHITE; perspective <= BLACK; ++perspective) {
+        PieceColor color = PieceColor(perspective);
+        qint16 *values = child.values[perspective];
+        subRow(values, featureWeights[nnueFeature(color, moved, from)]);
+        addRow(values, featureWeights[nnueFeature(color, placed, to)]);
+        if (!captured.isEmpty()) {
+            subRow(values, featureWeights[nnueFeature(color, captured, to)]);
+        }
+    }
+}
+
+int NnueNetwork::evaluate(const NnueAccumulator &accumulator, PieceColor sideToMove) const
+{
+    PieceColor opponent = sideToMove == WHITE ? BLACK : WHITE;
+    qint64 sum = qint64(clippedDot(accumulator.values[sideToMove], outputWeights)) +
+                 clippedDot(accumulator.values[opponent], outputWeights + NNUE_HIDDEN) +
+                 outputBias;
+    return int(sum * NNUE_SCALE / (NNUE_QA * NNUE_QB));
+}
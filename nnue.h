@@ -0,0 +1,64 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "chessboard.h"
+#include <QString>
+
+// Небольшая сеть оценки в духе NNUE: 768 входов (цвет × фигура × клетка)
+// → 128 нейронов на каждую сторону → 1 выход.
+// Первый слой хранится как аккумулятор и при ходе меняется только
+// на строки весов снятых и поставленных фигур; пересчёт целиком нужен лишь в корне.
+const int NNUE_INPUTS = 768;
+const int NNUE_HIDDEN = 128;
+
+// Квантование: аккумулятор в единицах 1/QA, выходные веса — 1/QB.
+// Выход сети, умноженный на NNUE_SCALE, — оценка в сантипешках
+const int NNUE_QA = 255;
+const int NNUE_QB = 64;
+const int NNUE_SCALE = 400;
+
+// Формат файла весов (little-endian): "NNUE", версия, размер скрытого слоя,
+// затем qint16 featureWeights[768][128], qint16 featureBias[128],
+// qint16 outputWeights[256], qint32 outputBias
+const quint32 NNUE_FILE_VERSION = 1;
+
+// Номер входа для фигуры piece на клетке square с точки зрения perspective.
+// Для черных доска отражается, так что «свои» фигуры всегда идут снизу вверх
+inline int nnueFeature(PieceColor perspective, const ChessPiece &piece, int square)
+{
+    int side = piece.color() == perspective ? 0 : 1;
+    int relativeSquare = perspective == WHITE ? square : square ^ 56;
+    return ((side * 6 + piece.type() - PAWN) * 64) + relativeSquare;
+}
+
+// Первый слой для обеих сторон: [WHITE] и [BLACK]
+struct alignas(32) NnueAccumulator {
+    qint16 values[2][NNUE_HIDDEN];
+};
+
+// Веса загружаются один раз; сеть только читается, поэтому
+// один экземпляр можно делить между потоками поиска
+class NnueNetwork {
+public:
+    NnueNetwork();
+
+    bool load(const QString &fileName);
+    bool isLoaded() const { return loaded; }
+
+    // Полный пересчёт аккумулятора по позиции
+    void refresh(const ChessBoardData &position, NnueAccumulator &accumulator) const;
+    // Аккумулятор после хода move; position — позиция до хода
+    void update(const NnueAccumulator &parent, NnueAccumulator &child,
+                const ChessBoardData &position, const ChessMove &move) const;
+    // Оценка в сантипешках с точки зрения sideToMove
+    int evaluate(const NnueAccumulator &accumulator, PieceColor sideToMove) const;
+
+private:
+    alignas(32) qint16 featureWeights[NNUE_INPUTS][NNUE_HIDDEN];
+    alignas(32) qint16 featureBias[NNUE_HIDDEN];
+    alignas(32) qint16 outputWeights[2 * NNUE_HIDDEN]; // сначала сторона, которая ходит
+    qint32 outputBias;
+    bool loaded;
+};
+
+#endif // NNUE_H
@@ -0,0 +1,115 @@
+// Проверка, что поиск не обращается к куче.
+//
+// Считаются вызовы malloc, calloc и realloc: через них идут и operator new,
+// и контейнеры Qt (QArrayData::allocate). Функции подменяются в самой
+// программе и передают вызов распределителю glibc, поэтому проверка
+// собирается только под Linux.
+//
+// Внутри findBestMoves допустимы лишь выделения под результат:
+// вектор линий и по вектору главного варианта на линию, то есть не больше
+// 1 + lineCount. Всё остальное время поиск живёт в арене SearchStack.
+//
+// Сборка — tools/alloctest.pro; make check в tools/tools.pro запускает проверку.
+
+#include "chessai.h"
+#include <cstdio>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *memory, size_t size);
+void __libc_free(void *memory);
+}
+
+namespace {
+
+// Счётчик без атомиков: поиск однопоточный, а до main и после него
+// выделения всё равно не учитываются
+long allocations = 0;
+bool counting = false;
+
+const int SEARCH_DEPTH = 7;
+
+const char *const POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    // Мат в один ход и пат: поиск заканчивается сразу
+    "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1",
+    "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"
+};
+
+}
+
+extern "C" {
+
+void *malloc(size_t size)
+{
+    if (counting) {
+        ++allocations;
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    if (counting) {
+        ++allocations;
+    }
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *memory, size_t size)
+{
+    if (counting) {
+        ++allocations;
+    }
+    return __libc_realloc(memory, size);
+}
+
+void free(void *memory)
+{
+    __libc_free(memory);
+}
+
+}
+
+int main()
+{
+    ChessAI ai(nullptr);
+    const QVector<quint64> history;
+    SearchLimits limits;
+    limits.depth = SEARCH_DEPTH;
+
+    // Проверка самой подмены: выделение через QVector должно быть замечено
+    counting = true;
+    {
+        QVector<ChessMove> probe;
+        probe.append(ChessMove());
+    }
+    counting = false;
+    if (allocations == 0) {
+        std::printf("malloc не подменён, проверка ничего не видит\n");
+        return 1;
+    }
+
+    int failures = 0;
+    for (const char *fen : POSITIONS) {
+        ChessBoardData position;
+        position.loadFen(QString::fromLatin1(fen));
+        for (int lineCount = 1; lineCount <= 3; lineCount += 2) {
+            allocations = 0;
+            counting = true;
+            QVector<SearchResult> lines = ai.findBestMoves(position, history, limits, lineCount);
+            counting = false;
+            long limit = 1 + lines.size();
+            std::printf("%s, линий %d: %llu узлов, %ld выделений (не больше %ld)\n", fen, lineCount,
+                        (unsigned long long)ai.searchedNodes(), allocations, limit);
+            if (allocations > limit) {
+                ++failures;
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
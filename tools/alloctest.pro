@@ -0,0 +1,5 @@
+include(tools.pri)
+TARGET = alloctest
+CONFIG += testcase
+SOURCES += alloctest.cpp $$ENGINE_SOURCES
+HEADERS += $$ENGINE_HEADERS
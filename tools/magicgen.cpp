@@ -0,0 +1,132 @@
+// Магические числа для таблиц дальнобойных фигур (bitboard.cpp).
+//
+// Без аргументов проверяет, что ROOK_MAGICS и BISHOP_MAGICS не дают
+// разрушительных коллизий, и возвращает 1, если хоть одно число негодно.
+// С --generate подбирает числа заново и печатает их в виде массивов для
+// bitboard.cpp. Генератор детерминирован: прежние сиды дают те же числа.
+//
+// Сборка — tools/magicgen.pro; make check в tools/tools.pro запускает проверку.
+
+#include "bitboard.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace Bitboards;
+
+namespace {
+
+// Подмножества маски и соответствующие атаки; не больше 4096 на клетку
+Bitboard occupancy[4096];
+Bitboard reference[4096];
+Bitboard filled[4096];
+int epoch[4096];
+
+// xorshift64*: детерминированный генератор для подбора магических чисел
+class MagicRandom {
+public:
+    explicit MagicRandom(quint64 seed) : state(seed) {}
+    quint64 next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+    // Магические числа с малым числом единиц находятся заметно быстрее
+    quint64 sparse() { return next() & next() & next(); }
+
+private:
+    quint64 state;
+};
+
+Bitboard sliderMask(int square, bool diagonal)
+{
+    return diagonal ? STEP_ATTACKS.bishopMask[square] : STEP_ATTACKS.rookMask[square];
+}
+
+// Заполняет occupancy и reference для клетки; возвращает число подмножеств
+int collectSubsets(int square, bool diagonal)
+{
+    Bitboard mask = sliderMask(square, diagonal);
+    int size = 0;
+    Bitboard subset = 0;
+    do {
+        occupancy[size] = subset;
+        reference[size] = slidingAttacks(square, subset, diagonal);
+        ++size;
+        subset = (subset - mask) & mask;
+    } while (subset);
+    return size;
+}
+
+// Число годится, если разные атаки не попадают в один индекс.
+// attempt помечает занятые индексы, чтобы не очищать filled перед каждой пробой
+bool isValidMagic(Bitboard magic, unsigned shift, int size, int attempt)
+{
+    for (int i = 0; i < size; ++i) {
+        unsigned index = unsigned((occupancy[i] * magic) >> shift);
+        if (epoch[index] < attempt) {
+            epoch[index] = attempt;
+            filled[index] = reference[i];
+        } else if (filled[index] != reference[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void generate(const char *name, bool diagonal, quint64 seed)
+{
+    MagicRandom random(seed);
+    std::memset(epoch, 0, sizeof(epoch));
+    int attempt = 0;
+
+    std::printf("const Bitboard %s[64] = {\n", name);
+    for (int sq = 0; sq < 64; ++sq) {
+        Bitboard mask = sliderMask(sq, diagonal);
+        unsigned shift = unsigned(64 - popCount(mask));
+        int size = collectSubsets(sq, diagonal);
+
+        Bitboard magic;
+        do {
+            do {
+                magic = random.sparse();
+            } while (popCount((magic * mask) >> 56) < 6);
+        } while (!isValidMagic(magic, shift, size, ++attempt));
+
+        std::printf("%s0x%016llXULL%s", sq % 4 == 0 ? "    " : "", (unsigned long long)magic,
+                    sq == 63 ? "\n" : (sq % 4 == 3 ? ",\n" : ", "));
+    }
+    std::printf("};\n");
+}
+
+int check(const Bitboard *magics, bool diagonal)
+{
+    std::memset(epoch, 0, sizeof(epoch));
+    int failures = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        unsigned shift = unsigned(64 - popCount(sliderMask(sq, diagonal)));
+        int size = collectSubsets(sq, diagonal);
+        if (!isValidMagic(magics[sq], shift, size, sq + 1)) {
+            std::printf("%s, клетка %d: коллизия\n", diagonal ? "слон" : "ладья", sq);
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--generate") == 0) {
+        generate("ROOK_MAGICS", false, 0xD1B54A32D192ED03ULL);
+        std::printf("\n");
+        generate("BISHOP_MAGICS", true, 0x9E3779B97F4A7C15ULL);
+        return 0;
+    }
+
+    int failures = check(ROOK_MAGICS, false) + check(BISHOP_MAGICS, true);
+    std::printf("Магические числа: %d ошибок\n", failures);
+    return failures == 0 ? 0 : 1;
+}
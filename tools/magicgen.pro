@@ -0,0 +1,5 @@
+include(tools.pri)
+TARGET = magicgen
+CONFIG += testcase
+SOURCES += magicgen.cpp $$BOARD_SOURCES
+HEADERS += $$BOARD_HEADERS
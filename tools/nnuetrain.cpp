@@ -0,0 +1,237 @@
+// Обучение сети оценки (nnue.h) на позициях из tools/selfplay.cpp --dump.
+//
+// Строка данных: «FEN | оценка | результат», оба числа с точки зрения стороны,
+// которая ходит. Цель — смесь оценки поиска и результата партии:
+//   target = lambda * sigmoid(score / 400) + (1 - lambda) * result,
+// ошибка — квадрат разности с sigmoid(выход сети). Обучение идёт в float
+// (Adam по мини-пакетам), затем веса квантуются в формат NnueNetwork::load.
+// Веса ограничены по модулю WEIGHT_LIMIT, чтобы квантованный аккумулятор
+// из 32 фигур не переполнял qint16.
+//
+// Сборка — tools/nnuetrain.pro (или все инструменты: qmake tools/tools.pro && make).
+//
+// Пример:
+//   ./selfplay --nodes 5000 --games 20000 --openings book.fen --dump data.txt
+//   ./nnuetrain --epochs 10 data.txt chess.nnue
+// Файл chess.nnue рядом с программой подхватывается главным окном.
+
+#include "nnue.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+const float WEIGHT_LIMIT = 1.98f;
+const float ADAM_BETA1 = 0.9f;
+const float ADAM_BETA2 = 0.999f;
+const float ADAM_EPSILON = 1e-8f;
+
+// Все параметры лежат в одном массиве: так Adam обходит их одним циклом
+const int FEATURE_WEIGHTS = 0;
+const int FEATURE_BIAS = FEATURE_WEIGHTS + NNUE_INPUTS * NNUE_HIDDEN;
+const int OUTPUT_WEIGHTS = FEATURE_BIAS + NNUE_HIDDEN;
+const int OUTPUT_BIAS = OUTPUT_WEIGHTS + 2 * NNUE_HIDDEN;
+const int PARAMETER_COUNT = OUTPUT_BIAS + 1;
+
+// Входы позиции: [0] — сторона, которая ходит, [1] — соперник
+struct Sample {
+    quint16 features[2][32];
+    int count;
+    float target;
+};
+
+float sigmoid(float x)
+{
+    return 1.0f / (1.0f + std::exp(-x));
+}
+
+bool loadSamples(const QString &fileName, float lambda, QVector<Sample> &samples)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList parts = in.readLine().split(QLatin1Char('|'));
+        ChessBoardData position;
+        if (parts.size() != 3 || !position.loadFen(parts[0].trimmed())) {
+            continue;
+        }
+
+        Sample sample;
+        sample.count = 0;
+        PieceColor side = position.currentPlayer;
+        PieceColor opponent = side == WHITE ? BLACK : WHITE;
+        Bitboard occupied = position.occupied();
+        while (occupied && sample.count < 32) {
+            int square = Bitboards::popLsb(occupied);
+            const ChessPiece &piece = position.board[square / 8][square % 8];
+            sample.features[0][sample.count] = quint16(nnueFeature(side, piece, square));
+            sample.features[1][sample.count] = quint16(nnueFeature(opponent, piece, square));
+            ++sample.count;
+        }
+
+        float score = parts[1].trimmed().toFloat();
+        float result = parts[2].trimmed().toFloat();
+        sample.target = lambda * sigmoid(score / NNUE_SCALE) + (1.0f - lambda) * result;
+        samples.append(sample);
+    }
+    return !samples.isEmpty();
+}
+
+// Прямой и обратный проход по одной позиции; возвращает квадрат ошибки
+float accumulateGradient(const QVector<float> &params, const Sample &sample, QVector<float> &grads)
+{
+    float hidden[2][NNUE_HIDDEN];
+    float output = params[OUTPUT_BIAS];
+    for (int side = 0; side < 2; ++side) {
+        for (int j = 0; j < NNUE_HIDDEN; ++j) {
+            hidden[side][j] = params[FEATURE_BIAS + j];
+        }
+        for (int i = 0; i < sample.count; ++i) {
+            const float *row = params.constData() + FEATURE_WEIGHTS + sample.features[side][i] * NNUE_HIDDEN;
+            for (int j = 0; j < NNUE_HIDDEN; ++j) {
+                hidden[side][j] += row[j];
+            }
+        }
+        for (int j = 0; j < NNUE_HIDDEN; ++j) {
+            output += qBound(0.0f, hidden[side][j], 1.0f) * params[OUTPUT_WEIGHTS + side * NNUE_HIDDEN + j];
+        }
+    }
+
+    float prediction = sigmoid(output);
+    float error = prediction - sample.target;
+    float gradient = 2.0f * error * prediction * (1.0f - prediction);
+
+    grads[OUTPUT_BIAS] += gradient;
+    for (int side = 0; side < 2; ++side) {
+        for (int j = 0; j < NNUE_HIDDEN; ++j) {
+            float h = hidden[side][j];
+            grads[OUTPUT_WEIGHTS + side * NNUE_HIDDEN + j] += gradient * qBound(0.0f, h, 1.0f);
+            if (h <= 0.0f || h >= 1.0f) {
+                continue;
+            }
+            float hiddenGradient = gradient * params[OUTPUT_WEIGHTS + side * NNUE_HIDDEN + j];
+            grads[FEATURE_BIAS + j] += hiddenGradient;
+            for (int i = 0; i < sample.count; ++i) {
+                grads[FEATURE_WEIGHTS + sample.features[side][i] * NNUE_HIDDEN + j] += hiddenGradient;
+            }
+        }
+    }
+    return error * error;
+}
+
+bool saveNetwork(const QString &fileName, const QVector<float> &params)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData("NNUE", 4);
+    out << NNUE_FILE_VERSION << quint32(NNUE_HIDDEN);
+    for (int i = FEATURE_WEIGHTS; i < OUTPUT_WEIGHTS; ++i) {
+        out << qint16(qRound(params[i] * NNUE_QA));
+    }
+    for (int i = OUTPUT_WEIGHTS; i < OUTPUT_BIAS; ++i) {
+        out << qint16(qRound(params[i] * NNUE_QB));
+    }
+    out << qint32(qRound(params[OUTPUT_BIAS] * NNUE_QA * NNUE_QB));
+    return out.status() == QDataStream::Ok;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Trains the NNUE evaluation network on self-play data");
+    parser.addHelpOption();
+    parser.addPositionalArgument("data", "Positions written by selfplay --dump.");
+    parser.addPositionalArgument("output", "Network file to write.");
+    QCommandLineOption epochsOption("epochs", "Passes over the data.", "n", "10");
+    QCommandLineOption batchOption("batch", "Mini-batch size.", "n", "1024");
+    QCommandLineOption rateOption("lr", "Adam learning rate.", "rate", "0.001");
+    QCommandLineOption lambdaOption("lambda", "Weight of the search score in the target.", "x", "0.75");
+    QCommandLineOption seedOption("seed", "Random seed.", "n", "1");
+    parser.addOptions({ epochsOption, batchOption, rateOption, lambdaOption, seedOption });
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 2) {
+        parser.showHelp(1);
+    }
+
+    QVector<Sample> samples;
+    if (!loadSamples(arguments[0], parser.value(lambdaOption).toFloat(), samples)) {
+        std::fprintf(stderr, "Нет данных в %s\n", qPrintable(arguments[0]));
+        return 1;
+    }
+    std::printf("Позиций: %d\n", samples.size());
+
+    std::mt19937 random(parser.value(seedOption).toUInt());
+    std::uniform_real_distribution<float> initial(-0.1f, 0.1f);
+    QVector<float> params(PARAMETER_COUNT, 0.0f);
+    for (int i = FEATURE_WEIGHTS; i < OUTPUT_BIAS; ++i) {
+        params[i] = initial(random);
+    }
+
+    QVector<float> grads(PARAMETER_COUNT, 0.0f);
+    QVector<float> moment(PARAMETER_COUNT, 0.0f);
+    QVector<float> velocity(PARAMETER_COUNT, 0.0f);
+    QVector<int> order(samples.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+
+    int epochs = parser.value(epochsOption).toInt();
+    int batchSize = qMax(1, parser.value(batchOption).toInt());
+    float rate = parser.value(rateOption).toFloat();
+    int step = 0;
+
+    for (int epoch = 1; epoch <= epochs; ++epoch) {
+        std::shuffle(order.begin(), order.end(), random);
+        double loss = 0.0;
+
+        for (int start = 0; start < order.size(); start += batchSize) {
+            int end = qMin(start + batchSize, order.size());
+            std::fill(grads.begin(), grads.end(), 0.0f);
+            for (int i = start; i < end; ++i) {
+                loss += accumulateGradient(params, samples[order[i]], grads);
+            }
+
+            ++step;
+            float correction1 = 1.0f - std::pow(ADAM_BETA1, float(step));
+            float correction2 = 1.0f - std::pow(ADAM_BETA2, float(step));
+            for (int p = 0; p < PARAMETER_COUNT; ++p) {
+                float g = grads[p] / (end - start);
+                moment[p] = ADAM_BETA1 * moment[p] + (1.0f - ADAM_BETA1) * g;
+                velocity[p] = ADAM_BETA2 * velocity[p] + (1.0f - ADAM_BETA2) * g * g;
+                params[p] -= rate * (moment[p] / correction1) /
+                             (std::sqrt(velocity[p] / correction2) + ADAM_EPSILON);
+                if (p != OUTPUT_BIAS) {
+                    params[p] = qBound(-WEIGHT_LIMIT, params[p], WEIGHT_LIMIT);
+                }
+            }
+        }
+        std::printf("Эпоха %d: ошибка %.6f\n", epoch, loss / samples.size());
+        std::fflush(stdout);
+    }
+
+    if (!saveNetwork(arguments[1], params)) {
+        std::fprintf(stderr, "Не удалось записать %s\n", qPrintable(arguments[1]));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,4 @@
+include(tools.pri)
+TARGET = nnuetrain
+SOURCES += nnuetrain.cpp $$BOARD_SOURCES $$ROOT/nnue.cpp
+HEADERS += $$BOARD_HEADERS $$ROOT/nnue.h
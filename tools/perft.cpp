@@ -0,0 +1,69 @@
+// Проверка генератора ходов: число позиций на глубине N из начальной.
+//
+// Правила доски — без рокировки и взятия на проходе, поэтому с глубины 5
+// счёт меньше общеизвестного 4865609 ровно на 258 взятий на проходе.
+// Без аргументов сверяет глубины 1-5 и возвращает 1 при расхождении;
+// с аргументами «perft <глубина> [FEN]» просто печатает счёт и время.
+//
+// Сборка — tools/perft.pro; make check в tools/tools.pro запускает проверку.
+
+#include "chessboard.h"
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const quint64 EXPECTED[] = { 1, 20, 400, 8902, 197281, 4865351 };
+
+quint64 perft(ChessBoardData &position, int depth)
+{
+    if (depth == 0) {
+        return 1;
+    }
+    MoveList moves;
+    position.generateLegalMoves(position.currentPlayer, moves);
+    if (depth == 1) {
+        return quint64(moves.size());
+    }
+
+    quint64 count = 0;
+    for (const ChessMove &move : moves) {
+        MoveUndo undo;
+        position.makeMove(move, undo);
+        count += perft(position, depth - 1);
+        position.unmakeMove(move, undo);
+    }
+    return count;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1) {
+        ChessBoardData position;
+        if (argc > 2 && !position.loadFen(QString::fromLatin1(argv[2]))) {
+            std::fprintf(stderr, "FEN не разобран: %s\n", argv[2]);
+            return 1;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        quint64 count = perft(position, std::atoi(argv[1]));
+        std::printf("%llu позиций, %lld мс\n", (unsigned long long)count, (long long)timer.elapsed());
+        return 0;
+    }
+
+    int failures = 0;
+    for (int depth = 1; depth < int(sizeof(EXPECTED) / sizeof(EXPECTED[0])); ++depth) {
+        ChessBoardData position;
+        quint64 count = perft(position, depth);
+        std::printf("perft(%d) = %llu", depth, (unsigned long long)count);
+        if (count != EXPECTED[depth]) {
+            std::printf(", ожидалось %llu", (unsigned long long)EXPECTED[depth]);
+            ++failures;
+        }
+        std::printf("\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,5 @@
+include(tools.pri)
+TARGET = perft
+CONFIG += testcase
+SOURCES += perft.cpp $$BOARD_SOURCES
+HEADERS += $$BOARD_HEADERS
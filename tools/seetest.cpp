@@ -0,0 +1,79 @@
+// Проверка статической оценки размена (ChessBoardData::staticExchange).
+//
+// Ожидаемые значения посчитаны полным перебором ответных взятий на клетке
+// при SEE_VALUES; программа печатает расхождения и возвращает 1, если они есть.
+//
+// Сборка — tools/seetest.pro; make check в tools/tools.pro запускает проверку.
+
+#include "chessboard.h"
+#include <cstdio>
+
+namespace {
+
+struct SeeCase {
+    const char *fen;
+    const char *move;   // «e2e4», пятая буква — фигура превращения
+    int expected;
+};
+
+const SeeCase CASES[] = {
+    // Незащищённая пешка
+    { "4k3/8/8/3p4/4P3/8/8/4K3 w - - 0 1", "e4d5", 100 },
+    // Ферзь берёт пешку, защищённую пешкой
+    { "4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1", "d2d5", -800 },
+    // Сдвоенные ладьи: вторая вступает в размен после ухода первой
+    { "3r3k/3r4/8/8/8/3R4/3R4/4K3 w - - 0 1", "d3d7", 500 },
+    // После BxP dxB чёрным выгодно добрать пешку конём
+    { "r1bqkbnr/pp1p1pp1/n1p4p/2P1p3/2NP4/8/PP2PPPP/R1BQKBNR b - - 0 1", "f8c5", -130 },
+    // Длинный размен с рентгеном ферзя за ладьёй
+    { "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", -220 },
+    // Превращение без взятия
+    { "8/P7/8/8/8/8/8/k6K w - - 0 1", "a7a8q", 800 },
+};
+
+int squareRow(char rank)
+{
+    return '8' - rank;
+}
+
+int squareCol(char file)
+{
+    return file - 'a';
+}
+
+ChessMove parseMove(const char *text)
+{
+    int fr = squareRow(text[1]);
+    int fc = squareCol(text[0]);
+    int tr = squareRow(text[3]);
+    int tc = squareCol(text[2]);
+    switch (text[4]) {
+    case 'n': return ChessMove(fr, fc, tr, tc, KNIGHT);
+    case 'b': return ChessMove(fr, fc, tr, tc, BISHOP);
+    case 'r': return ChessMove(fr, fc, tr, tc, ROOK);
+    case 'q': return ChessMove(fr, fc, tr, tc, QUEEN);
+    default: return ChessMove(fr, fc, tr, tc);
+    }
+}
+
+}
+
+int main()
+{
+    int failures = 0;
+    for (const SeeCase &test : CASES) {
+        ChessBoardData position;
+        if (!position.loadFen(QString::fromLatin1(test.fen))) {
+            std::printf("FEN не разобран: %s\n", test.fen);
+            ++failures;
+            continue;
+        }
+        int value = position.staticExchange(parseMove(test.move));
+        if (value != test.expected) {
+            std::printf("%s %s: %d, ожидалось %d\n", test.fen, test.move, value, test.expected);
+            ++failures;
+        }
+    }
+    std::printf("SEE: %d ошибок\n", failures);
+    return failures == 0 ? 0 : 1;
+}
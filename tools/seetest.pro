@@ -0,0 +1,5 @@
+include(tools.pri)
+TARGET = seetest
+CONFIG += testcase
+SOURCES += seetest.cpp $$BOARD_SOURCES
+HEADERS += $$BOARD_HEADERS
@@ -0,0 +1,512 @@
+// Самоигра двух настроек движка для проверки изменений.
+//
+// Базовая (--base) и проверяемая (--test) конфигурации SearchOptions играют
+// пары партий со сменой цвета из одной стартовой позиции. Партии идут
+// параллельно, у каждого потока свои экземпляры ChessAI с таблицей транспозиций
+// по --hash МБ на движок. На ход даётся фиксированный бюджет узлов (--nodes),
+// времени (--movetime) или глубины.
+// После каждой партии печатается Elo проверяемой конфигурации с 95%
+// интервалом и LLR теста SPRT; матч останавливается, как только LLR выходит
+// за границы [log(beta / (1 - alpha)), log((1 - beta) / alpha)].
+//
+// С бюджетом в узлах или глубине поиск детерминирован (таблица транспозиций
+// очищается перед каждой партией): повтор стартовой позиции повторяет партию
+// и только раздувает статистику SPRT. Поэтому стартовая позиция пары — дебют
+// из книги (встроенной или --openings, по одной позиции FEN в строке) плюс
+// --random-plies случайных ходов. Ходы выбираются генератором с --seed
+// и номером пары, так что матч воспроизводим, а позиции почти не повторяются.
+// Случайный ход не отдаёт фигуру по размену (SEE >= 0), чтобы дебют
+// оставался примерно равным. С --random-plies 0 и без --movetime
+// партий не больше двух на дебют.
+// Сравниваются настройки одной сборки: новый код стоит включать флагом
+// SearchOptions, чтобы его можно было проверить против старого поведения.
+//
+// Сборка — tools/selfplay.pro (или все инструменты: qmake tools/tools.pro && make).
+//
+// Флаг nnue в --base или --test включает оценку сетью из файла --network.
+// С --dump позиции партий пишутся для tools/nnuetrain.cpp строками
+// «FEN | оценка | результат», оба числа с точки зрения стороны, которая ходит.
+//
+// Пример: проверить, что нулевой ход даёт не меньше 10 Elo
+//   ./selfplay --base nonull --test "" --nodes 20000 --elo0 0 --elo1 10
+
+#include "chessai.h"
+#include "nnue.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QRunnable>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+// Партия длиннее считается ничьей
+const int MAX_GAME_PLIES = 400;
+// На малой выборке дисперсия оценена плохо и LLR скачет: раньше не останавливаемся
+const int SPRT_MIN_GAMES = 30;
+// Случайные ходы не должны сами по себе заканчивать партию
+const int RANDOM_OPENING_ATTEMPTS = 16;
+// Для обучения берём только спокойные позиции без матовых оценок
+const int DUMP_MAX_SCORE = 2000;
+
+const char *const DEFAULT_OPENINGS[] = {
+    "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1",
+    "rnbqkbnr/pppppppp/8/8/3P4/8/PPP1PPPP/RNBQKBNR b KQkq - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+    "rnbqkbnr/ppp2ppp/4p3/3p4/3PP3/8/PPP2PPP/RNBQKBNR w KQkq - 0 3",
+    "rnbqkbnr/pp2pppp/2p5/3p4/3PP3/8/PPP2PPP/RNBQKBNR w KQkq - 0 3",
+    "rnbqkbnr/ppp2ppp/4p3/3p4/2PP4/8/PP2PPPP/RNBQKBNR w KQkq - 0 3",
+    "rnbqkb1r/pppppp1p/5np1/8/2PP4/8/PP2PPPP/RNBQKBNR w KQkq - 0 3",
+    "rnbqkbnr/pppp1ppp/8/4p3/2P5/8/PP1PPPPP/RNBQKBNR w KQkq - 0 2",
+    "rnbqkbnr/ppp1pppp/8/3p4/8/5N2/PPPPPPPP/RNBQKB1R w KQkq - 0 2",
+    "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+    "r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4"
+};
+
+// Настройки поиска из списка через запятую: nonull,nolmr,nofut,norazor,noasp,nosee,nnue
+bool parseSearchOptions(const QString &spec, SearchOptions &options, bool &useNetwork)
+{
+    const QStringList flags = spec.split(QLatin1Char(','));
+    for (const QString &flag : flags) {
+        const QString name = flag.trimmed();
+        if (name.isEmpty()) {
+            continue;
+        } else if (name == QLatin1String("nonull")) {
+            options.nullMove = false;
+        } else if (name == QLatin1String("nolmr")) {
+            options.lateMoveReductions = false;
+        } else if (name == QLatin1String("nofut")) {
+            options.futility = false;
+        } else if (name == QLatin1String("norazor")) {
+            options.razoring = false;
+        } else if (name == QLatin1String("noasp")) {
+            options.aspirationWindows = false;
+        } else if (name == QLatin1String("nosee")) {
+            options.seePruning = false;
+        } else if (name == QLatin1String("nnue")) {
+            useNetwork = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Голые короли или король с одной лёгкой фигурой против короля
+bool isInsufficientMaterial(const ChessBoardData &position)
+{
+    Bitboard occupied = position.occupied();
+    int pieces = Bitboards::popCount(occupied);
+    Bitboard minors = position.byType[KNIGHT] | position.byType[BISHOP];
+    return pieces == 2 || (pieces == 3 && (occupied & minors));
+}
+
+// Дебют пары pair: позиция книги и plies случайных ходов, не проигрывающих размен.
+// Одинаков для обеих партий пары, в каком бы потоке они ни игрались
+ChessBoardData randomizedOpening(const ChessBoardData &book, int plies, quint32 seed, int pair)
+{
+    std::seed_seq sequence{ seed, quint32(pair) };
+    std::mt19937 random(sequence);
+
+    for (int attempt = 0; attempt < RANDOM_OPENING_ATTEMPTS; ++attempt) {
+        ChessBoardData position = book;
+        for (int ply = 0; ply < plies; ++ply) {
+            MoveList moves;
+            MoveList safeMoves;
+            position.generateLegalMoves(position.currentPlayer, moves);
+            for (const ChessMove &move : moves) {
+                if (position.staticExchange(move) >= 0) {
+                    safeMoves.append(move);
+                }
+            }
+            const MoveList &choice = safeMoves.isEmpty() ? moves : safeMoves;
+            if (choice.isEmpty()) {
+                break;
+            }
+            position.makeMove(choice[int(random() % quint32(choice.size()))]);
+        }
+        position.updateGameState();
+        if (position.gameState == IN_PROGRESS) {
+            return position;
+        }
+    }
+    return book;
+}
+
+// Позиция для обучения сети; результат партии дописывается в конце
+struct TrainingSample {
+    QString fen;
+    int score;
+    PieceColor side;
+};
+
+// Результат партии: WHITE_WIN, BLACK_WIN или ничья (STALEMATE, DRAW).
+// Если samples не nullptr, туда собираются позиции для обучения
+GameState playGame(ChessAI *white, ChessAI *black, const ChessBoardData &start,
+                   const SearchLimits &limits, QVector<TrainingSample> *samples)
+{
+    ChessBoardData position = start;
+    QVector<quint64> history;
+    history.reserve(MAX_GAME_PLIES);
+
+    for (int ply = 0; ply < MAX_GAME_PLIES; ++ply) {
+        position.updateGameState();
+        if (position.gameState != IN_PROGRESS) {
+            return position.gameState;
+        }
+        // Троекратное повторение: текущая позиция и ещё две такие же в истории
+        if (position.isRepetition(history, 2) || isInsufficientMaterial(position)) {
+            return DRAW;
+        }
+
+        ChessAI *engine = position.currentPlayer == WHITE ? white : black;
+        SearchResult result = engine->findBestMove(position, history, limits);
+        if (result.bestMove.isNull()) {
+            return DRAW;
+        }
+        const ChessMove &move = result.bestMove;
+        if (samples && qAbs(result.score) < DUMP_MAX_SCORE && !position.isInCheck(position.currentPlayer) &&
+            move.flag() != PROMOTION_MOVE && position.board[move.toRow()][move.toCol()].isEmpty()) {
+            samples->append({ position.toFen(), result.score, position.currentPlayer });
+        }
+        history.append(position.key);
+        position.makeMove(move);
+    }
+    return DRAW;
+}
+
+// Счёт матча с точки зрения проверяемой конфигурации
+struct MatchScore {
+    int wins;
+    int draws;
+    int losses;
+
+    MatchScore() : wins(0), draws(0), losses(0) {}
+    int games() const { return wins + draws + losses; }
+    double score() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+
+    // Дисперсия очков за партию
+    double variance() const
+    {
+        if (!games()) {
+            return 0.0;
+        }
+        double m = score();
+        return (wins * (1.0 - m) * (1.0 - m) + draws * (0.5 - m) * (0.5 - m) +
+                losses * m * m) / games();
+    }
+};
+
+double scoreToElo(double score)
+{
+    score = qBound(1e-6, score, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+double eloToScore(double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// Полуширина 95% интервала Elo
+double eloMargin(const MatchScore &score)
+{
+    if (!score.games()) {
+        return 0.0;
+    }
+    double error = 1.96 * std::sqrt(score.variance() / score.games());
+    return (scoreToElo(score.score() + error) - scoreToElo(score.score() - error)) / 2.0;
+}
+
+// LLR в нормальном приближении: H0 — разница elo0, H1 — elo1
+double sprtLlr(const MatchScore &score, double elo0, double elo1)
+{
+    double variance = score.variance();
+    if (variance <= 0.0) {
+        return 0.0;
+    }
+    double s0 = eloToScore(elo0);
+    double s1 = eloToScore(elo1);
+    return score.games() * (s1 - s0) * (2.0 * score.score() - s0 - s1) / (2.0 * variance);
+}
+
+struct MatchConfig {
+    SearchOptions baseOptions;
+    SearchOptions testOptions;
+    const NnueNetwork *baseNetwork;
+    const NnueNetwork *testNetwork;
+    SearchLimits limits;
+    int hashMegabytes;
+    QVector<ChessBoardData> openings;
+    int randomPlies;
+    quint32 seed;
+    int games;
+    double elo0;
+    double elo1;
+    double lowerBound;
+    double upperBound;
+};
+
+// Общее состояние матча; потоки берут номера партий и сдают результаты
+class Match {
+public:
+    Match(const MatchConfig &matchConfig, QIODevice *dumpDevice)
+        : config(matchConfig), dump(dumpDevice), nextGame(0), stopped(false) {}
+
+    const MatchConfig &settings() const { return config; }
+    bool isDumping() const { return dump.device() != nullptr; }
+
+    bool takeGame(int *game)
+    {
+        QMutexLocker locker(&mutex);
+        if (stopped || nextGame >= config.games) {
+            return false;
+        }
+        *game = nextGame++;
+        return true;
+    }
+
+    void addResult(int game, GameState result, bool testIsWhite,
+                   const QVector<TrainingSample> &samples)
+    {
+        QMutexLocker locker(&mutex);
+        for (const TrainingSample &sample : samples) {
+            double whiteResult = result == WHITE_WIN ? 1.0 : (result == BLACK_WIN ? 0.0 : 0.5);
+            double sideResult = sample.side == WHITE ? whiteResult : 1.0 - whiteResult;
+            dump << sample.fen << " | " << sample.score << " | " << sideResult << "\n";
+        }
+        if (!samples.isEmpty()) {
+            dump.flush();
+        }
+
+        if (result == WHITE_WIN || result == BLACK_WIN) {
+            if ((result == WHITE_WIN) == testIsWhite) {
+                ++score.wins;
+            } else {
+                ++score.losses;
+            }
+        } else {
+            ++score.draws;
+        }
+
+        double llr = sprtLlr(score, config.elo0, config.elo1);
+        std::printf("Партия %d: +%d =%d -%d  Elo %+.1f ± %.1f  LLR %.2f [%.2f, %.2f]\n",
+                    game + 1, score.wins, score.draws, score.losses,
+                    scoreToElo(score.score()), eloMargin(score),
+                    llr, config.lowerBound, config.upperBound);
+        std::fflush(stdout);
+
+        if (!stopped && score.games() >= SPRT_MIN_GAMES &&
+            (llr <= config.lowerBound || llr >= config.upperBound)) {
+            stopped = true;
+            verdict = llr >= config.upperBound ? QStringLiteral("H1") : QStringLiteral("H0");
+        }
+    }
+
+    MatchScore result() const { return score; }
+    QString sprtVerdict() const { return verdict; }
+
+private:
+    MatchConfig config;
+    QTextStream dump;
+    QMutex mutex;
+    int nextGame;
+    bool stopped;
+    MatchScore score;
+    QString verdict;
+};
+
+class GameWorker : public QRunnable {
+public:
+    explicit GameWorker(Match *sharedMatch) : match(sharedMatch) {}
+
+    void run() override
+    {
+        const MatchConfig &config = match->settings();
+        ChessAI base(nullptr);
+        ChessAI test(nullptr);
+        base.setTranspositionTableSize(config.hashMegabytes);
+        test.setTranspositionTableSize(config.hashMegabytes);
+        base.setSearchOptions(config.baseOptions);
+        test.setSearchOptions(config.testOptions);
+        base.setNetwork(config.baseNetwork);
+        test.setNetwork(config.testNetwork);
+
+        QVector<TrainingSample> samples;
+        QVector<TrainingSample> *samplesOut = match->isDumping() ? &samples : nullptr;
+        int game;
+        while (match->takeGame(&game)) {
+            samples.clear();
+            // Партия не должна зависеть от того, какие партии поток сыграл до неё
+            base.clearTranspositionTable();
+            test.clearTranspositionTable();
+            // Пара партий на дебют: в чётной проверяемая конфигурация играет белыми
+            int pair = game / 2;
+            ChessBoardData opening = randomizedOpening(config.openings[pair % config.openings.size()],
+                                                       config.randomPlies, config.seed, pair);
+            bool testIsWhite = game % 2 == 0;
+            GameState result = testIsWhite ? playGame(&test, &base, opening, config.limits, samplesOut)
+                                           : playGame(&base, &test, opening, config.limits, samplesOut);
+            match->addResult(game, result, testIsWhite, samples);
+        }
+    }
+
+private:
+    Match *match;
+};
+
+bool loadOpenings(const QString &fileName, QVector<ChessBoardData> &openings)
+{
+    if (fileName.isEmpty()) {
+        for (const char *fen : DEFAULT_OPENINGS) {
+            ChessBoardData position;
+            position.loadFen(QString::fromLatin1(fen));
+            openings.append(position);
+        }
+        return true;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+        ChessBoardData position;
+        if (!position.loadFen(line)) {
+            std::fprintf(stderr, "Пропущена позиция: %s\n", qPrintable(line));
+            continue;
+        }
+        openings.append(position);
+    }
+    return !openings.isEmpty();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Self-play match between two engine configurations");
+    parser.addHelpOption();
+    QCommandLineOption baseOption("base", "Base configuration, e.g. nonull,nolmr.", "flags");
+    QCommandLineOption testOption("test", "Tested configuration.", "flags");
+    QCommandLineOption gamesOption("games", "Maximum number of games.", "n", "1000");
+    QCommandLineOption concurrencyOption("concurrency", "Parallel games.", "n",
+                                         QString::number(QThread::idealThreadCount()));
+    QCommandLineOption nodesOption("nodes", "Node budget per move.", "n");
+    QCommandLineOption movetimeOption("movetime", "Time budget per move, ms.", "ms");
+    QCommandLineOption depthOption("depth", "Depth limit per move.", "n");
+    QCommandLineOption hashOption("hash", "Transposition table per engine, MB.", "mb",
+                                  QString::number(DEFAULT_TT_SIZE_MB));
+    QCommandLineOption openingsOption("openings", "File with one FEN per line.", "file");
+    QCommandLineOption randomPliesOption("random-plies", "Random plies after each opening.", "n", "4");
+    QCommandLineOption seedOption("seed", "Seed for the random plies.", "n", "1");
+    QCommandLineOption networkOption("network", "NNUE weights for configurations with the nnue flag.", "file");
+    QCommandLineOption dumpOption("dump", "Append training positions to this file.", "file");
+    QCommandLineOption elo0Option("elo0", "SPRT H0 Elo difference.", "elo", "0");
+    QCommandLineOption elo1Option("elo1", "SPRT H1 Elo difference.", "elo", "5");
+    QCommandLineOption alphaOption("alpha", "SPRT type I error.", "p", "0.05");
+    QCommandLineOption betaOption("beta", "SPRT type II error.", "p", "0.05");
+    parser.addOptions({ baseOption, testOption, gamesOption, concurrencyOption, nodesOption,
+                        movetimeOption, depthOption, hashOption, openingsOption, randomPliesOption, seedOption, networkOption, dumpOption, elo0Option, elo1Option,
+                        alphaOption, betaOption });
+    parser.process(app);
+
+    MatchConfig config;
+    bool baseUsesNetwork = false;
+    bool testUsesNetwork = false;
+    if (!parseSearchOptions(parser.value(baseOption), config.baseOptions, baseUsesNetwork) ||
+        !parseSearchOptions(parser.value(testOption), config.testOptions, testUsesNetwork)) {
+        std::fprintf(stderr, "Неизвестный флаг; допустимы nonull,nolmr,nofut,norazor,noasp,nosee,nnue\n");
+        return 1;
+    }
+
+    // Веса большие и только читаются: один экземпляр на все потоки
+    QScopedPointer<NnueNetwork> network;
+    if (baseUsesNetwork || testUsesNetwork) {
+        network.reset(new NnueNetwork);
+        if (!network->load(parser.value(networkOption))) {
+            std::fprintf(stderr, "Не удалось загрузить сеть из --network\n");
+            return 1;
+        }
+    }
+    config.baseNetwork = baseUsesNetwork ? network.data() : nullptr;
+    config.testNetwork = testUsesNetwork ? network.data() : nullptr;
+    if (!loadOpenings(parser.value(openingsOption), config.openings)) {
+        std::fprintf(stderr, "Не удалось прочитать дебюты\n");
+        return 1;
+    }
+
+    if (parser.isSet(nodesOption)) {
+        config.limits.nodes = parser.value(nodesOption).toULongLong();
+    }
+    if (parser.isSet(movetimeOption)) {
+        config.limits.timeMs = parser.value(movetimeOption).toLongLong();
+    }
+    if (parser.isSet(depthOption)) {
+        config.limits.depth = parser.value(depthOption).toInt();
+    }
+    if (!parser.isSet(nodesOption) && !parser.isSet(movetimeOption) && !parser.isSet(depthOption)) {
+        config.limits.nodes = 20000;
+    }
+
+    config.hashMegabytes = qMax(1, parser.value(hashOption).toInt());
+    config.randomPlies = qMax(0, parser.value(randomPliesOption).toInt());
+    config.seed = parser.value(seedOption).toUInt();
+    config.games = qMax(1, parser.value(gamesOption).toInt());
+    // Без случайных ходов и ограничения по времени повтор дебюта даёт ту же партию
+    if (config.randomPlies == 0 && !parser.isSet(movetimeOption) && config.games > 2 * config.openings.size()) {
+        config.games = 2 * config.openings.size();
+        std::printf("Партий не больше %d: по две на дебют\n", config.games);
+        if (config.games < SPRT_MIN_GAMES) {
+            std::fprintf(stderr, "ВНИМАНИЕ: SPRT не остановится раньше %d партий, а их всего %d. "
+                         "Нужны --random-plies, --movetime или больше дебютов в --openings\n",
+                         SPRT_MIN_GAMES, config.games);
+        }
+    }
+    config.elo0 = parser.value(elo0Option).toDouble();
+    config.elo1 = parser.value(elo1Option).toDouble();
+    double alpha = parser.value(alphaOption).toDouble();
+    double beta = parser.value(betaOption).toDouble();
+    config.lowerBound = std::log(beta / (1.0 - alpha));
+    config.upperBound = std::log((1.0 - beta) / alpha);
+
+    QFile dumpFile(parser.value(dumpOption));
+    if (parser.isSet(dumpOption) && !dumpFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        std::fprintf(stderr, "Не удалось открыть файл для --dump\n");
+        return 1;
+    }
+
+    Match match(config, dumpFile.isOpen() ? &dumpFile : nullptr);
+    QThreadPool pool;
+    int concurrency = qMax(1, parser.value(concurrencyOption).toInt());
+    pool.setMaxThreadCount(concurrency);
+    for (int i = 0; i < concurrency; ++i) {
+        pool.start(new GameWorker(&match));
+    }
+    pool.waitForDone();
+
+    MatchScore score = match.result();
+    std::printf("Итог: %d партий, +%d =%d -%d, Elo %+.1f ± %.1f",
+                score.games(), score.wins, score.draws, score.losses,
+                scoreToElo(score.score()), eloMargin(score));
+    if (!match.sprtVerdict().isEmpty()) {
+        std::printf(", SPRT: принята %s", qPrintable(match.sprtVerdict()));
+    }
+    std::printf("\n");
+    return 0;
+}
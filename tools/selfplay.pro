@@ -0,0 +1,4 @@
+include(tools.pri)
+TARGET = selfplay
+SOURCES += selfplay.cpp $$ENGINE_SOURCES
+HEADERS += $$ENGINE_HEADERS
@@ -0,0 +1,12 @@
+# Общие настройки консольных инструментов: исходники движка берутся из корня
+QT += core gui widgets
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+ROOT = $$PWD/..
+INCLUDEPATH += $$ROOT
+
+BOARD_SOURCES = $$ROOT/bitboard.cpp $$ROOT/chessboard.cpp
+BOARD_HEADERS = $$ROOT/bitboard.h $$ROOT/chessboard.h
+ENGINE_SOURCES = $$BOARD_SOURCES $$ROOT/chessai.cpp $$ROOT/nnue.cpp $$ROOT/transpositiontable.cpp
+ENGINE_HEADERS = $$BOARD_HEADERS $$ROOT/chessai.h $$ROOT/nnue.h $$ROOT/transpositiontable.h
@@ -0,0 +1,16 @@
+# Инструменты и проверки движка: qmake tools/tools.pro && make,
+# make check запускает проверки (perft, seetest, magicgen, alloctest)
+TEMPLATE = subdirs
+
+SUBDIRS = perft seetest magicgen selfplay nnuetrain
+perft.file = perft.pro
+seetest.file = seetest.pro
+magicgen.file = magicgen.pro
+selfplay.file = selfplay.pro
+nnuetrain.file = nnuetrain.pro
+
+# Подмена malloc рассчитана на glibc
+linux {
+    SUBDIRS += alloctest
+    alloctest.file = alloctest.pro
+}
@@ -0,0 +1,47 @@
+#include "transpositiontable.h"
+
+TranspositionTable::TranspositionTable(int megabytes)
+    : mask(0), generation(0)
+{
+    // Число записей — степень двойки, чтобы индекс брался маской
+    quint64 count = 1;
+    while (count * 2 * sizeof(TTEntry) <= quint64(megabytes) * 1024 * 1024) {
+        count *= 2;
+    }
+    entries.resize(int(count));
+    mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    TTEntry empty = {};
+    entries.fill(empty);
+}
+
+const TTEntry *TranspositionTable::probe(quint64 key) const
+{
+    const TTEntry &entry = entries[int(key & mask)];
+    if (entry.bound == BOUND_NONE || entry.key != quint32(key >> 32)) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+void TranspositionTable::store(quint64 key, int depth, int score, TTBound bound, const ChessMove &move)
+{
+    TTEntry &entry = entries[int(key & mask)];
+    bool samePosition = entry.key == quint32(key >> 32);
+    if (samePosition && entry.generation == generation && entry.depth > depth && bound != BOUND_EXACT) {
+        return;
+    }
+    // Без хода оставляем прежний лучший ход этой позиции
+    if (!samePosition || !move.isNull()) {
+        entry.move = move;
+    }
+    entry.key = quint32(key >> 32);
+    entry.score = score;
+    entry.depth = qint8(depth);
+    entry.bound = bound;
+    entry.generation = generation;
+}
@@ -0,0 +1,42 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include "chessboard.h"
+#include <QVector>
+
+// Что известно об оценке: точная, не выше (все ходы провалились) или не ниже (отсечение)
+enum TTBound : quint8 {
+    BOUND_NONE,
+    BOUND_UPPER,
+    BOUND_LOWER,
+    BOUND_EXACT
+};
+
+struct TTEntry {
+    quint32 key;       // старшие биты ключа Zobrist; младшие задают индекс
+    qint32 score;      // матовые оценки — от этой позиции, а не от корня
+    ChessMove move;
+    qint8 depth;
+    TTBound bound;
+    quint8 generation; // номер поиска, в котором записана позиция
+};
+
+// Таблица транспозиций: выделяется один раз, дальше поиск к куче не обращается.
+// Заменяется запись из прошлого поиска, другой позиции или не глубже новой
+class TranspositionTable {
+public:
+    explicit TranspositionTable(int megabytes);
+
+    void clear();
+    // Вызывается перед каждым поиском, чтобы старые записи вытеснялись первыми
+    void newSearch() { generation = quint8(generation + 1); }
+    const TTEntry *probe(quint64 key) const;
+    void store(quint64 key, int depth, int score, TTBound bound, const ChessMove &move);
+
+private:
+    QVector<TTEntry> entries;
+    quint64 mask;
+    quint8 generation;
+};
+
+#endif // TRANSPOSITIONTABLE_H